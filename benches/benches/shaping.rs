@@ -0,0 +1,144 @@
+use benchmarks::{cases, fonts, LoadedCase};
+use criterion::{black_box, criterion_group, criterion_main, BatchSize, Criterion};
+use harfruzz::bench::{Stage, StageInput};
+use harfruzz::ttf_parser::Tag;
+use harfruzz::{Face, ShapePlan, UnicodeBuffer, Variation};
+
+fn variations(case: &LoadedCase) -> Vec<Variation> {
+    case.case
+        .variations
+        .iter()
+        .map(|(tag, value)| Variation {
+            tag: Tag::from_bytes(tag),
+            value: *value,
+        })
+        .collect()
+}
+
+fn buffer(case: &LoadedCase) -> UnicodeBuffer {
+    let mut buffer = UnicodeBuffer::new();
+    buffer.push_str(&case.text);
+    buffer.reset_clusters();
+    buffer.guess_segment_properties();
+    buffer
+}
+
+fn face<'a>(case: &'a LoadedCase) -> Face<'a> {
+    let mut face = Face::from_slice(&case.font_data, 0).unwrap();
+    face.set_variations(&variations(case));
+    face
+}
+
+fn plan(face: &Face, buffer: &UnicodeBuffer) -> ShapePlan {
+    ShapePlan::new(face, buffer.direction(), Some(buffer.script()), buffer.language().as_ref(), &[])
+}
+
+#[cfg(feature = "hb")]
+fn hb_font<'a>(case: &'a LoadedCase) -> harfbuzz_rs::Owned<harfbuzz_rs::Font<'a>> {
+    let face = harfbuzz_rs::Face::from_bytes(&case.font_data, 0);
+    let mut font = harfbuzz_rs::Font::new(face);
+    let variations: Vec<_> = case
+        .case
+        .variations
+        .iter()
+        .map(|(tag, value)| harfbuzz_rs::Variation::new(harfbuzz_rs::Tag(Tag::from_bytes(tag).0), *value))
+        .collect();
+    font.set_variations(&variations);
+    font
+}
+
+/// Parsing a face, without any shaping.
+fn face_creation(c: &mut Criterion) {
+    let cases = cases();
+    let mut group = c.benchmark_group("face");
+    for path in fonts(&cases) {
+        let data = std::fs::read(path).unwrap();
+        let name = path.rsplit('/').next().unwrap();
+        group.bench_function(format!("{}/hr", name), |b| b.iter(|| Face::from_slice(black_box(&data), 0).unwrap()));
+        #[cfg(feature = "hb")]
+        group.bench_function(format!("{}/hb", name), |b| b.iter(|| harfbuzz_rs::Font::new(harfbuzz_rs::Face::from_bytes(black_box(&data), 0))));
+    }
+    group.finish();
+}
+
+/// Parsing a face and shaping a text with it once, which includes parsing the tables
+/// and lookups that are used on first access.
+fn face_first_shape(c: &mut Criterion) {
+    let mut group = c.benchmark_group("face/first-shape");
+    for case in cases() {
+        let case = case.load();
+        group.bench_function(&case.case.name, |b| {
+            b.iter_batched(
+                || buffer(&case),
+                |buffer| {
+                    let face = face(&case);
+                    harfruzz::shape_with_plan(&face, &plan(&face, &buffer), buffer)
+                },
+                BatchSize::SmallInput,
+            )
+        });
+    }
+    group.finish();
+}
+
+/// Compiling a shape plan for the segment properties of each text.
+fn plan_creation(c: &mut Criterion) {
+    let mut group = c.benchmark_group("plan");
+    for case in cases() {
+        let case = case.load();
+        let face = face(&case);
+        let buffer = buffer(&case);
+        group.bench_function(&case.case.name, |b| b.iter(|| plan(&face, &buffer)));
+    }
+    group.finish();
+}
+
+/// Shaping with a face and plan created up front.
+///
+/// `harfbuzz_rs` has no way to hold on to a plan, so it uses its internal plan cache instead.
+fn shaping(c: &mut Criterion) {
+    let mut group = c.benchmark_group("shape");
+    for case in cases() {
+        let case = case.load();
+        let face = face(&case);
+        let plan = plan(&face, &buffer(&case));
+        group.bench_function(format!("{}/hr", case.case.name), |b| {
+            b.iter_batched(|| buffer(&case), |buffer| harfruzz::shape_with_plan(&face, &plan, buffer), BatchSize::SmallInput)
+        });
+
+        #[cfg(feature = "hb")]
+        {
+            let font = hb_font(&case);
+            group.bench_function(format!("{}/hb", case.case.name), |b| {
+                b.iter_batched(
+                    || harfbuzz_rs::UnicodeBuffer::new().add_str(&case.text),
+                    |buffer| harfbuzz_rs::shape(&font, buffer, &[]),
+                    BatchSize::SmallInput,
+                )
+            });
+        }
+    }
+    group.finish();
+}
+
+/// Individual shaping stages, each starting from a buffer already in the right state.
+///
+/// `Substitute` and `Position` measure `morx` and `kerx` for the AAT fonts.
+fn stages(c: &mut Criterion) {
+    let stages = [("normalize", Stage::Normalize), ("substitute", Stage::Substitute), ("position", Stage::Position), ("kern", Stage::Kern)];
+
+    for (stage_name, stage) in stages {
+        let mut group = c.benchmark_group(format!("stage/{}", stage_name));
+        for case in cases() {
+            let case = case.load();
+            let face = face(&case);
+            let plan = plan(&face, &buffer(&case));
+            let input = StageInput::new(&face, &plan, buffer(&case), stage);
+            group.bench_function(&case.case.name, |b| b.iter_batched(|| input.clone(), |mut input| input.run(&face, &plan), BatchSize::SmallInput));
+        }
+        group.finish();
+    }
+}
+
+criterion_group!(benches, face_creation, face_first_shape, plan_creation, shaping, stages);
+criterion_main!(benches);
@@ -1,238 +1,158 @@
-#![feature(test)]
-#![allow(dead_code)]
-#![allow(unused_imports)]
+//! The benchmark corpus, shared by all benchmarks.
 
-extern crate test;
+use std::collections::BTreeSet;
 
-use rustybuzz::ttf_parser::Tag;
-
-struct CustomVariation {
-    tag: rustybuzz::ttf_parser::Tag,
-    value: f32,
+/// A font and a text to shape with it.
+pub struct Case {
+    /// A unique name, used as the benchmark id.
+    pub name: String,
+    pub font_path: &'static str,
+    pub text_path: &'static str,
+    pub variations: &'static [(&'static [u8; 4], f32)],
 }
 
-impl Into<rustybuzz::Variation> for CustomVariation {
-    fn into(self) -> rustybuzz::Variation {
-        rustybuzz::Variation { tag: self.tag, value: self.value }
-    }
+/// A `Case` with its files loaded.
+pub struct LoadedCase<'a> {
+    pub case: &'a Case,
+    pub font_data: Vec<u8>,
+    pub text: String,
 }
 
-impl Into<harfbuzz_rs::Variation> for CustomVariation {
-    fn into(self) -> harfbuzz_rs::Variation {
-        harfbuzz_rs::Variation::new(harfbuzz_rs::Tag(self.tag.0), self.value)
+impl Case {
+    pub fn load(&self) -> LoadedCase {
+        let font_data = std::fs::read(self.font_path).unwrap_or_else(|e| panic!("Could not read {}: {}", self.font_path, e));
+        let text = std::fs::read_to_string(self.text_path)
+            .unwrap_or_else(|e| panic!("Could not read {}: {}", self.text_path, e))
+            .trim()
+            .to_string();
+        LoadedCase { case: self, font_data, text }
     }
-}
-
-macro_rules! simple_bench {
-    ($name:ident, $font_path:expr, $text_path:expr) => {
-        mod $name {
-            use super::*;
-            use test::Bencher;
-
-            #[bench]
-            fn rb(bencher: &mut Bencher) {
-                let font_data = std::fs::read($font_path).unwrap();
-                let text = std::fs::read_to_string($text_path).unwrap().trim().to_string();
-                bencher.iter(|| {
-                    test::black_box({
-                        let face = rustybuzz::Face::from_slice(&font_data, 0).unwrap();
-                        let mut buffer = rustybuzz::UnicodeBuffer::new();
-                        buffer.push_str(&text);
-                        buffer.reset_clusters();
-                        rustybuzz::shape(&face, &[], buffer);
-                    });
-                })
-            }
-
-            #[cfg(feature = "hb")]
-            #[bench]
-            fn hb(bencher: &mut Bencher) {
-                let font_data = std::fs::read($font_path).unwrap();
-                let text = std::fs::read_to_string($text_path).unwrap().trim().to_string();
-                bencher.iter(|| {
-                    test::black_box({
-                        let face = harfbuzz_rs::Face::from_bytes(&font_data, 0);
-                        let font = harfbuzz_rs::Font::new(face);
-                        let buffer = harfbuzz_rs::UnicodeBuffer::new().add_str(&text);
-                        harfbuzz_rs::shape(&font, buffer, &[])
-                    });
-                })
-            }
-        }
-    };
-
-    // Keep in sync with above.
-    ($name:ident, $font_path:expr, $text_path:expr, $variations:expr) => {
-        mod $name {
-            use super::*;
-            use test::Bencher;
-
-            #[bench]
-            fn rb(bencher: &mut Bencher) {
-                let font_data = std::fs::read($font_path).unwrap();
-                let text = std::fs::read_to_string($text_path).unwrap().trim().to_string();
-                bencher.iter(|| {
-                    test::black_box({
-                        let mut face = rustybuzz::Face::from_slice(&font_data, 0).unwrap();
-                        face.set_variations($variations);
-                        let mut buffer = rustybuzz::UnicodeBuffer::new();
-                        buffer.push_str(&text);
-                        buffer.reset_clusters();
-                        rustybuzz::shape(&face, &[], buffer);
-                    });
-                })
-            }
-
-            #[cfg(feature = "hb")]
-            #[bench]
-            fn hb(bencher: &mut Bencher) {
-                let font_data = std::fs::read($font_path).unwrap();
-                let text = std::fs::read_to_string($text_path).unwrap().trim().to_string();
-                bencher.iter(|| {
-                    test::black_box({
-                        let face = harfbuzz_rs::Face::from_bytes(&font_data, 0);
-                        let mut font = harfbuzz_rs::Font::new(face);
-                        font.set_variations($variations);
-                        let buffer = harfbuzz_rs::UnicodeBuffer::new().add_str(&text);
-                        harfbuzz_rs::shape(&font, buffer, &[])
-                    });
-                })
-            }
-        }
-    };
-}
-
-mod english {
-    use super::*;
-
-    simple_bench!(short_zalgo, "fonts/NotoSans-Regular.ttf", "texts/english/short_zalgo.txt");
-    simple_bench!(long_zalgo, "fonts/NotoSans-Regular.ttf", "texts/english/long_zalgo.txt");
-    simple_bench!(word_1, "fonts/NotoSans-Regular.ttf", "texts/english/word_1.txt");
-    simple_bench!(word_2, "fonts/NotoSans-Regular.ttf", "texts/english/word_2.txt");
-    simple_bench!(word_3, "fonts/NotoSans-Regular.ttf", "texts/english/word_3.txt");
-    simple_bench!(word_4, "fonts/NotoSans-Regular.ttf", "texts/english/word_4.txt");
-    simple_bench!(sentence_1, "fonts/NotoSans-Regular.ttf", "texts/english/sentence_1.txt");
-    simple_bench!(sentence_2, "fonts/NotoSans-Regular.ttf", "texts/english/sentence_2.txt");
-    simple_bench!(paragraph_short, "fonts/NotoSans-Regular.ttf", "texts/english/paragraph_short.txt");
-    simple_bench!(paragraph_medium, "fonts/NotoSans-Regular.ttf", "texts/english/paragraph_medium.txt");
-    simple_bench!(paragraph_long, "fonts/NotoSans-Regular.ttf", "texts/english/paragraph_long.txt");
-
-    simple_bench!(sentence_mono, "fonts/RobotoMono-Regular.ttf", "texts/english/sentence_1.txt");
-    simple_bench!(paragraph_long_mono, "fonts/RobotoMono-Regular.ttf", "texts/english/paragraph_long.txt");
-
-    use crate::CustomVariation;
-
-    const WIDTH_VAR: CustomVariation = CustomVariation {
-        tag: Tag::from_bytes(b"wdth"),
-        value: 50.0,
-    };
-
-    const WIDTH_VAR_DEFAULT: CustomVariation = CustomVariation {
-        tag: Tag::from_bytes(b"wdth"),
-        value: 100.0,
-    };
-
-    simple_bench!(variations, "fonts/NotoSans-VariableFont.ttf", "texts/english/paragraph_long.txt", &[WIDTH_VAR.into()]);
-    simple_bench!(variations_default, "fonts/NotoSans-VariableFont.ttf", "texts/english/paragraph_long.txt", &[WIDTH_VAR_DEFAULT.into()]);
-
-    #[cfg(target_os = "macos")]
-    simple_bench!(aat_word_1, "/System/Library/Fonts/Supplemental/Zapfino.ttf", "texts/english/word_1.txt");
-    #[cfg(target_os = "macos")]
-    simple_bench!(aat_sentence_1, "/System/Library/Fonts/Supplemental/Zapfino.ttf", "texts/english/sentence_1.txt");
-    #[cfg(target_os = "macos")]
-    simple_bench!(aat_paragraph_long, "/System/Library/Fonts/Supplemental/Zapfino.ttf", "texts/english/paragraph_long.txt");
-}
 
-mod arabic {
-    use super::*;
-
-    simple_bench!(word_1, "fonts/NotoSansArabic-Regular.ttf", "texts/arabic/word_1.txt");
-    simple_bench!(word_2, "fonts/NotoSansArabic-Regular.ttf", "texts/arabic/word_2.txt");
-    simple_bench!(word_3, "fonts/NotoSansArabic-Regular.ttf", "texts/arabic/word_3.txt");
-    simple_bench!(sentence_1, "fonts/NotoSansArabic-Regular.ttf", "texts/arabic/sentence_1.txt");
-    simple_bench!(sentence_2, "fonts/NotoSansArabic-Regular.ttf", "texts/arabic/sentence_2.txt");
-    simple_bench!(paragraph_short, "fonts/NotoSansArabic-Regular.ttf", "texts/arabic/paragraph_short.txt");
-    simple_bench!(paragraph_medium, "fonts/NotoSansArabic-Regular.ttf", "texts/arabic/paragraph_medium.txt");
-    simple_bench!(paragraph_long, "fonts/NotoSansArabic-Regular.ttf", "texts/arabic/paragraph_long.txt");
+    /// Whether the font can be read on this machine.
+    ///
+    /// Some AAT fonts are only available on macOS.
+    pub fn is_available(&self) -> bool {
+        std::path::Path::new(self.font_path).exists()
+    }
 }
 
-mod khmer {
-    use super::*;
-
-    simple_bench!(word_1, "fonts/NotoSansKhmer-Regular.ttf", "texts/khmer/word_1.txt");
-    simple_bench!(word_2, "fonts/NotoSansKhmer-Regular.ttf", "texts/khmer/word_2.txt");
-    simple_bench!(word_3, "fonts/NotoSansKhmer-Regular.ttf", "texts/khmer/word_3.txt");
-    simple_bench!(sentence_1, "fonts/NotoSansKhmer-Regular.ttf", "texts/khmer/sentence_1.txt");
-    simple_bench!(sentence_2, "fonts/NotoSansKhmer-Regular.ttf", "texts/khmer/sentence_2.txt");
-    simple_bench!(paragraph_medium, "fonts/NotoSansKhmer-Regular.ttf", "texts/khmer/paragraph_medium.txt");
-    simple_bench!(paragraph_long_1, "fonts/NotoSansKhmer-Regular.ttf", "texts/khmer/paragraph_long_1.txt");
-    simple_bench!(paragraph_long_2, "fonts/NotoSansKhmer-Regular.ttf", "texts/khmer/paragraph_long_2.txt");
-
-    #[cfg(target_os = "macos")]
-    simple_bench!(aat_word_1, "/System/Library/Fonts/Supplemental/Khmer MN.ttc", "texts/khmer/word_1.txt");
-    #[cfg(target_os = "macos")]
-    simple_bench!(aat_sentence_1, "/System/Library/Fonts/Supplemental/Khmer MN.ttc", "texts/khmer/sentence_1.txt");
-    #[cfg(target_os = "macos")]
-    simple_bench!(aat_paragraph_long_1, "/System/Library/Fonts/Supplemental/Khmer MN.ttc", "texts/khmer/paragraph_long_1.txt");
+fn case(script: &str, name: &str, font_path: &'static str, text_path: &'static str) -> Case {
+    Case {
+        name: format!("{}/{}", script, name),
+        font_path,
+        text_path,
+        variations: &[],
+    }
 }
 
-mod hebrew {
-    use super::*;
-
-    simple_bench!(word_1, "fonts/NotoSansHebrew-Regular.ttf", "texts/hebrew/word_1.txt");
-    simple_bench!(word_2, "fonts/NotoSansHebrew-Regular.ttf", "texts/hebrew/word_2.txt");
-    simple_bench!(sentence_1, "fonts/NotoSansHebrew-Regular.ttf", "texts/hebrew/sentence_1.txt");
-    simple_bench!(sentence_2, "fonts/NotoSansHebrew-Regular.ttf", "texts/hebrew/sentence_2.txt");
-    simple_bench!(paragraph_medium, "fonts/NotoSansHebrew-Regular.ttf", "texts/hebrew/paragraph_medium.txt");
-    simple_bench!(paragraph_long_1, "fonts/NotoSansHebrew-Regular.ttf", "texts/hebrew/paragraph_long_1.txt");
-    simple_bench!(paragraph_long_2, "fonts/NotoSansHebrew-Regular.ttf", "texts/hebrew/paragraph_long_2.txt");
-}
+/// Returns all cases, in a stable order.
+pub fn cases() -> Vec<Case> {
+    let mut cases = Vec::new();
+
+    macro_rules! add {
+        ($script:expr, $font:expr, [$($name:expr),* $(,)?]) => {
+            $(cases.push(case(
+                $script,
+                $name,
+                concat!("fonts/", $font),
+                concat!("texts/", $script, "/", $name, ".txt"),
+            ));)*
+        };
+    }
 
-mod myanmar {
-    use super::*;
-
-    simple_bench!(word_1, "fonts/NotoSansMyanmar-Regular.ttf", "texts/myanmar/word_1.txt");
-    simple_bench!(word_2, "fonts/NotoSansMyanmar-Regular.ttf", "texts/myanmar/word_2.txt");
-    simple_bench!(sentence_1, "fonts/NotoSansMyanmar-Regular.ttf", "texts/myanmar/sentence_1.txt");
-    simple_bench!(sentence_2, "fonts/NotoSansMyanmar-Regular.ttf", "texts/myanmar/sentence_2.txt");
-    simple_bench!(paragraph_short, "fonts/NotoSansMyanmar-Regular.ttf", "texts/myanmar/paragraph_short.txt");
-    simple_bench!(paragraph_medium, "fonts/NotoSansMyanmar-Regular.ttf", "texts/myanmar/paragraph_medium.txt");
-    simple_bench!(paragraph_long, "fonts/NotoSansMyanmar-Regular.ttf", "texts/myanmar/paragraph_long.txt");
-
-    #[cfg(target_os = "macos")]
-    simple_bench!(aat_word_1, "/System/Library/Fonts/Supplemental/Myanmar MN.ttc", "texts/myanmar/word_1.txt");
-    #[cfg(target_os = "macos")]
-    simple_bench!(aat_sentence_1, "/System/Library/Fonts/Supplemental/Myanmar MN.ttc", "texts/myanmar/sentence_1.txt");
-    #[cfg(target_os = "macos")]
-    simple_bench!(aat_paragraph_long, "/System/Library/Fonts/Supplemental/Myanmar MN.ttc", "texts/myanmar/paragraph_long.txt");
-}
+    macro_rules! add_aat {
+        ($script:expr, $id:expr, $font:expr, $text:expr) => {
+            cases.push(case(
+                $script,
+                $id,
+                concat!("/System/Library/Fonts/Supplemental/", $font),
+                concat!("texts/", $script, "/", $text, ".txt"),
+            ));
+        };
+    }
 
-mod hindi {
-    use super::*;
-
-    simple_bench!(word_1, "fonts/NotoSansDevanagari-Regular.ttf", "texts/hindi/word_1.txt");
-    simple_bench!(word_2, "fonts/NotoSansDevanagari-Regular.ttf", "texts/hindi/word_2.txt");
-    simple_bench!(sentence_1, "fonts/NotoSansDevanagari-Regular.ttf", "texts/hindi/sentence_1.txt");
-    simple_bench!(sentence_2, "fonts/NotoSansDevanagari-Regular.ttf", "texts/hindi/sentence_2.txt");
-    simple_bench!(paragraph_short, "fonts/NotoSansDevanagari-Regular.ttf", "texts/hindi/paragraph_short.txt");
-    simple_bench!(paragraph_medium, "fonts/NotoSansDevanagari-Regular.ttf", "texts/hindi/paragraph_medium.txt");
-    simple_bench!(paragraph_long, "fonts/NotoSansDevanagari-Regular.ttf", "texts/hindi/paragraph_long.txt");
-
-    #[cfg(target_os = "macos")]
-    simple_bench!(aat_word, "/System/Library/Fonts/Supplemental/Devanagari Sangam MN.ttc", "texts/hindi/word_1.txt");
-    #[cfg(target_os = "macos")]
-    simple_bench!(aat_sentence, "/System/Library/Fonts/Supplemental/Devanagari Sangam MN.ttc", "texts/hindi/sentence_1.txt");
-    #[cfg(target_os = "macos")]
-    simple_bench!(aat_paragraph_long, "/System/Library/Fonts/Supplemental/Devanagari Sangam MN.ttc", "texts/hindi/paragraph_long.txt");
+    add!(
+        "english",
+        "NotoSans-Regular.ttf",
+        [
+            "short_zalgo",
+            "long_zalgo",
+            "word_1",
+            "word_2",
+            "word_3",
+            "word_4",
+            "sentence_1",
+            "sentence_2",
+            "paragraph_short",
+            "paragraph_medium",
+            "paragraph_long",
+        ]
+    );
+    cases.push(case("english", "sentence_mono", "fonts/RobotoMono-Regular.ttf", "texts/english/sentence_1.txt"));
+    cases.push(case("english", "paragraph_long_mono", "fonts/RobotoMono-Regular.ttf", "texts/english/paragraph_long.txt"));
+    cases.push(Case {
+        variations: &[(b"wdth", 50.0)],
+        ..case("english", "variations", "fonts/NotoSans-VariableFont.ttf", "texts/english/paragraph_long.txt")
+    });
+    cases.push(Case {
+        variations: &[(b"wdth", 100.0)],
+        ..case("english", "variations_default", "fonts/NotoSans-VariableFont.ttf", "texts/english/paragraph_long.txt")
+    });
+    add_aat!("english", "aat_word_1", "Zapfino.ttf", "word_1");
+    add_aat!("english", "aat_sentence_1", "Zapfino.ttf", "sentence_1");
+    add_aat!("english", "aat_paragraph_long", "Zapfino.ttf", "paragraph_long");
+
+    add!(
+        "arabic",
+        "NotoSansArabic-Regular.ttf",
+        ["word_1", "word_2", "word_3", "sentence_1", "sentence_2", "paragraph_short", "paragraph_medium", "paragraph_long"]
+    );
+
+    add!(
+        "khmer",
+        "NotoSansKhmer-Regular.ttf",
+        ["word_1", "word_2", "word_3", "sentence_1", "sentence_2", "paragraph_medium", "paragraph_long_1", "paragraph_long_2"]
+    );
+    add_aat!("khmer", "aat_word_1", "Khmer MN.ttc", "word_1");
+    add_aat!("khmer", "aat_sentence_1", "Khmer MN.ttc", "sentence_1");
+    add_aat!("khmer", "aat_paragraph_long_1", "Khmer MN.ttc", "paragraph_long_1");
+
+    add!(
+        "hebrew",
+        "NotoSansHebrew-Regular.ttf",
+        ["word_1", "word_2", "sentence_1", "sentence_2", "paragraph_medium", "paragraph_long_1", "paragraph_long_2"]
+    );
+
+    add!(
+        "myanmar",
+        "NotoSansMyanmar-Regular.ttf",
+        ["word_1", "word_2", "sentence_1", "sentence_2", "paragraph_short", "paragraph_medium", "paragraph_long"]
+    );
+    add_aat!("myanmar", "aat_word_1", "Myanmar MN.ttc", "word_1");
+    add_aat!("myanmar", "aat_sentence_1", "Myanmar MN.ttc", "sentence_1");
+    add_aat!("myanmar", "aat_paragraph_long", "Myanmar MN.ttc", "paragraph_long");
+
+    add!(
+        "hindi",
+        "NotoSansDevanagari-Regular.ttf",
+        ["word_1", "word_2", "sentence_1", "sentence_2", "paragraph_short", "paragraph_medium", "paragraph_long"]
+    );
+    add_aat!("hindi", "aat_word", "Devanagari Sangam MN.ttc", "word_1");
+    add_aat!("hindi", "aat_sentence", "Devanagari Sangam MN.ttc", "sentence_1");
+    add_aat!("hindi", "aat_paragraph_long", "Devanagari Sangam MN.ttc", "paragraph_long");
+
+    add!(
+        "thai",
+        "NotoSansThai-Regular.ttf",
+        ["word_1", "word_2", "sentence_1", "paragraph_short", "paragraph_medium", "paragraph_long"]
+    );
+
+    cases.retain(Case::is_available);
+    cases
 }
 
-mod thai {
-    use super::*;
-
-    simple_bench!(word_1, "fonts/NotoSansThai-Regular.ttf", "texts/thai/word_1.txt");
-    simple_bench!(word_2, "fonts/NotoSansThai-Regular.ttf", "texts/thai/word_2.txt");
-    simple_bench!(sentence_1, "fonts/NotoSansThai-Regular.ttf", "texts/thai/sentence_1.txt");
-    simple_bench!(paragraph_short, "fonts/NotoSansThai-Regular.ttf", "texts/thai/paragraph_short.txt");
-    simple_bench!(paragraph_medium, "fonts/NotoSansThai-Regular.ttf", "texts/thai/paragraph_medium.txt");
-    simple_bench!(paragraph_long, "fonts/NotoSansThai-Regular.ttf", "texts/thai/paragraph_long.txt");
+/// Returns the distinct fonts used by `cases`.
+pub fn fonts(cases: &[Case]) -> Vec<&'static str> {
+    let fonts: BTreeSet<_> = cases.iter().map(|case| case.font_path).collect();
+    fonts.into_iter().collect()
 }
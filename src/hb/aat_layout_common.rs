@@ -1,6 +1,12 @@
+use alloc::boxed::Box;
+use core::sync::atomic::{AtomicU16, Ordering};
+use ttf_parser::GlyphId;
+
 use crate::hb::aat_map::range_flags_t;
 use crate::hb::buffer::hb_buffer_t;
 use crate::hb::face::hb_font_t;
+use crate::hb::fonta::once_cell::OnceCell;
+use crate::hb::fonta::ot::cache_budget::CacheBudget;
 use crate::hb::hb_mask_t;
 
 pub struct hb_aat_apply_context_t<'a> {
@@ -20,3 +26,106 @@ impl<'a> hb_aat_apply_context_t<'a> {
         }
     }
 }
+
+/// Memory available for the class arrays of a single face, in bytes.
+const HB_AAT_CLASS_CACHE_BUDGET: usize = 2 * 1024 * 1024;
+
+/// Marks a class that hasn't been looked up yet.
+const HB_AAT_CLASS_CACHE_EMPTY: u16 = u16::MAX;
+
+#[derive(Clone, Copy)]
+pub enum hb_aat_class_table_t {
+    Morx,
+    Kerx,
+    Kern,
+}
+
+type hb_aat_subtable_classes_t = OnceCell<Box<[OnceCell<Option<Box<[AtomicU16]>>>]>>;
+
+/// Glyph classes of the state machine subtables of a face, cached in arrays
+/// indexed by glyph id.
+///
+/// A class lookup is a binary search in most fonts and state machines do one for
+/// every glyph they visit, so each subtable gets a class array on first use,
+/// while the budget of the face allows. The array starts out empty and the class
+/// of a glyph is looked up the first time a state machine visits it.
+pub struct hb_aat_class_cache_t {
+    morx: hb_aat_subtable_classes_t,
+    kerx: hb_aat_subtable_classes_t,
+    kern: hb_aat_subtable_classes_t,
+    budget: CacheBudget,
+}
+
+impl Default for hb_aat_class_cache_t {
+    fn default() -> Self {
+        Self {
+            morx: OnceCell::new(),
+            kerx: OnceCell::new(),
+            kern: OnceCell::new(),
+            budget: CacheBudget::new(HB_AAT_CLASS_CACHE_BUDGET),
+        }
+    }
+}
+
+impl hb_aat_class_cache_t {
+    /// Returns the class array of a subtable, or `None` if it doesn't fit
+    /// into the budget.
+    ///
+    /// `subtable_count` is the number of state machine subtables of the table.
+    pub fn classes(
+        &self,
+        table: hb_aat_class_table_t,
+        subtable_count: impl FnOnce() -> usize,
+        index: usize,
+        num_glyphs: u16,
+    ) -> Option<hb_aat_classes_t<'_>> {
+        let subtables = match table {
+            hb_aat_class_table_t::Morx => &self.morx,
+            hb_aat_class_table_t::Kerx => &self.kerx,
+            hb_aat_class_table_t::Kern => &self.kern,
+        };
+        let subtables =
+            subtables.get_or_init(|| (0..subtable_count()).map(|_| OnceCell::new()).collect());
+        let classes = subtables.get(index)?.get_or_init(|| {
+            let len = usize::from(num_glyphs);
+            if len == 0 || !self.budget.reserve(len * core::mem::size_of::<AtomicU16>()) {
+                return None;
+            }
+            Some(
+                (0..len)
+                    .map(|_| AtomicU16::new(HB_AAT_CLASS_CACHE_EMPTY))
+                    .collect(),
+            )
+        });
+        classes
+            .as_deref()
+            .map(|classes| hb_aat_classes_t { classes })
+    }
+}
+
+/// The class array of a subtable, see [`hb_aat_class_cache_t`].
+#[derive(Clone, Copy)]
+pub struct hb_aat_classes_t<'a> {
+    classes: &'a [AtomicU16],
+}
+
+impl hb_aat_classes_t<'_> {
+    /// Returns the class of a glyph, looking it up with `class` if it isn't cached yet.
+    ///
+    /// Glyphs past the glyphs of the face, like the deleted glyph, are never cached.
+    #[inline]
+    pub fn get(&self, glyph: GlyphId, class: impl FnOnce() -> u16) -> u16 {
+        let Some(entry) = self.classes.get(usize::from(glyph.0)) else {
+            return class();
+        };
+        match entry.load(Ordering::Relaxed) {
+            HB_AAT_CLASS_CACHE_EMPTY => {
+                // A class equal to the sentinel is simply never cached.
+                let class = class();
+                entry.store(class, Ordering::Relaxed);
+                class
+            }
+            class => class,
+        }
+    }
+}
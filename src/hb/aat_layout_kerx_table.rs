@@ -2,6 +2,7 @@ use core::convert::TryFrom;
 
 use ttf_parser::{ankr, apple_layout, kerx, FromData, GlyphId};
 
+use super::aat_layout_common::hb_aat_class_table_t;
 use super::buffer::*;
 use super::hb_font_t;
 use super::ot_layout::TableIndex;
@@ -53,7 +54,7 @@ pub(crate) fn apply(
     buffer.unsafe_to_concat(None, None);
 
     let mut seen_cross_stream = false;
-    for subtable in face.tables().kerx?.subtables {
+    for (index, subtable) in face.tables().kerx?.subtables.into_iter().enumerate() {
         if subtable.variable {
             continue;
         }
@@ -95,7 +96,7 @@ pub(crate) fn apply(
                     depth: 0,
                 };
 
-                apply_state_machine_kerning(&subtable, sub, &mut driver, plan, buffer);
+                apply_state_machine_kerning(&subtable, sub, index, &mut driver, plan, face, buffer);
             }
             kerx::Format::Format2(_) => {
                 if !plan.requested_kerning {
@@ -113,7 +114,7 @@ pub(crate) fn apply(
                     ankr_table: face.tables().ankr.clone(),
                 };
 
-                apply_state_machine_kerning(&subtable, sub, &mut driver, plan, buffer);
+                apply_state_machine_kerning(&subtable, sub, index, &mut driver, plan, face, buffer);
             }
             kerx::Format::Format6(_) => {
                 if !plan.requested_kerning {
@@ -220,21 +221,37 @@ impl KerxEntryDataExt for apple_layout::GenericStateEntry<kerx::EntryData> {
 fn apply_state_machine_kerning<T, E>(
     subtable: &kerx::Subtable,
     state_table: &T,
+    subtable_index: usize,
     driver: &mut dyn StateTableDriver<T, E>,
     plan: &hb_ot_shape_plan_t,
+    face: &hb_font_t,
     buffer: &mut hb_buffer_t,
 ) where
     T: ExtendedStateTableExt<E>,
     E: FromData + Copy,
     apple_layout::GenericStateEntry<E>: KerxEntryDataExt,
 {
+    let classes = face.face_data.aat_classes.classes(
+        hb_aat_class_table_t::Kerx,
+        || {
+            face.tables()
+                .kerx
+                .map_or(0, |kerx| kerx.subtables.into_iter().count())
+        },
+        subtable_index,
+        face.number_of_glyphs(),
+    );
+
     let mut state = START_OF_TEXT;
     buffer.idx = 0;
     loop {
         let class = if buffer.idx < buffer.len {
-            state_table
-                .class(buffer.info[buffer.idx].as_glyph())
-                .unwrap_or(1)
+            let glyph = buffer.info[buffer.idx].as_glyph();
+            let class = || state_table.class(glyph).unwrap_or(1);
+            match classes {
+                Some(classes) => classes.get(glyph, class),
+                None => class(),
+            }
         } else {
             u16::from(apple_layout::class::END_OF_TEXT)
         };
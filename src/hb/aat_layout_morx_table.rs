@@ -2,7 +2,7 @@ use super::aat_layout::*;
 use super::aat_map::{hb_aat_map_builder_t, hb_aat_map_t, range_flags_t};
 use super::buffer::{hb_buffer_t, UnicodeProps};
 use super::{hb_font_t, hb_glyph_info_t};
-use crate::hb::aat_layout_common::hb_aat_apply_context_t;
+use crate::hb::aat_layout_common::{hb_aat_apply_context_t, hb_aat_class_table_t};
 use crate::hb::ot_layout::MAX_CONTEXT_LENGTH;
 use alloc::vec;
 use ttf_parser::{apple_layout, morx, FromData, GlyphId, LazyArray32};
@@ -75,9 +75,14 @@ pub fn apply<'a>(c: &mut hb_aat_apply_context_t<'a>, map: &'a mut hb_aat_map_t)
     let chain_len = chains.clone().into_iter().count();
     map.chain_flags.resize(chain_len, vec![]);
 
+    // Subtables are numbered across all chains, for the class cache.
+    let mut subtable_index = 0;
     for (chain, chain_flags) in chains.into_iter().zip(map.chain_flags.iter_mut()) {
         c.range_flags = Some(chain_flags.as_mut_slice());
         for subtable in chain.subtables {
+            let index = subtable_index;
+            subtable_index += 1;
+
             if let Some(range_flags) = c.range_flags.as_ref() {
                 if range_flags.len() == 1 && (subtable.feature_flags & range_flags[0].flags == 0) {
                     continue;
@@ -129,7 +134,7 @@ pub fn apply<'a>(c: &mut hb_aat_apply_context_t<'a>, map: &'a mut hb_aat_map_t)
                 c.buffer.reverse();
             }
 
-            apply_subtable(&subtable.kind, c);
+            apply_subtable(&subtable.kind, index, c);
 
             if reverse {
                 c.buffer.reverse();
@@ -157,15 +162,33 @@ trait driver_context_t<T: FromData> {
 
 const START_OF_TEXT: u16 = 0;
 
+fn subtable_count(face: &hb_font_t) -> usize {
+    face.tables().morx.as_ref().map_or(0, |morx| {
+        morx.chains
+            .into_iter()
+            .map(|chain| chain.subtables.into_iter().count())
+            .sum()
+    })
+}
+
 fn drive<T: FromData>(
     machine: &apple_layout::ExtendedStateTable<T>,
     c: &mut dyn driver_context_t<T>,
+    subtable_index: usize,
     ac: &mut hb_aat_apply_context_t,
 ) {
     if !c.in_place() {
         ac.buffer.clear_output();
     }
 
+    let face = ac.face;
+    let classes = face.face_data.aat_classes.classes(
+        hb_aat_class_table_t::Morx,
+        || subtable_count(face),
+        subtable_index,
+        face.number_of_glyphs(),
+    );
+
     let mut state = START_OF_TEXT;
     let mut last_range = ac.range_flags.as_ref().and_then(|rf| {
         if rf.len() > 1 {
@@ -208,7 +231,12 @@ fn drive<T: FromData>(
         }
 
         let class = if ac.buffer.idx < ac.buffer.len {
-            machine.class(ac.buffer.cur(0).as_glyph()).unwrap_or(1)
+            let glyph = ac.buffer.cur(0).as_glyph();
+            let class = || machine.class(glyph).unwrap_or(1);
+            match classes {
+                Some(classes) => classes.get(glyph, class),
+                None => class(),
+            }
         } else {
             u16::from(apple_layout::class::END_OF_TEXT)
         };
@@ -318,12 +346,12 @@ fn drive<T: FromData>(
     }
 }
 
-fn apply_subtable(kind: &morx::SubtableKind, ac: &mut hb_aat_apply_context_t) {
+fn apply_subtable(kind: &morx::SubtableKind, index: usize, ac: &mut hb_aat_apply_context_t) {
     match kind {
         morx::SubtableKind::Rearrangement(ref table) => {
             let mut c = RearrangementCtx { start: 0, end: 0 };
 
-            drive::<()>(table, &mut c, ac);
+            drive::<()>(table, &mut c, index, ac);
         }
         morx::SubtableKind::Contextual(ref table) => {
             let mut c = ContextualCtx {
@@ -335,7 +363,7 @@ fn apply_subtable(kind: &morx::SubtableKind, ac: &mut hb_aat_apply_context_t) {
                 table,
             };
 
-            drive::<morx::ContextualEntryData>(&table.state, &mut c, ac);
+            drive::<morx::ContextualEntryData>(&table.state, &mut c, index, ac);
         }
         morx::SubtableKind::Ligature(ref table) => {
             let mut c = LigatureCtx {
@@ -344,7 +372,7 @@ fn apply_subtable(kind: &morx::SubtableKind, ac: &mut hb_aat_apply_context_t) {
                 match_positions: [0; LIGATURE_MAX_MATCHES],
             };
 
-            drive::<u16>(&table.state, &mut c, ac);
+            drive::<u16>(&table.state, &mut c, index, ac);
         }
         morx::SubtableKind::NonContextual(ref lookup) => {
             let face_if_has_glyph_classes =
@@ -400,7 +428,7 @@ fn apply_subtable(kind: &morx::SubtableKind, ac: &mut hb_aat_apply_context_t) {
                 glyphs: table.glyphs,
             };
 
-            drive::<morx::InsertionEntryData>(&table.state, &mut c, ac);
+            drive::<morx::InsertionEntryData>(&table.state, &mut c, index, ac);
         }
     }
 }
@@ -1,3 +1,5 @@
+#[cfg(feature = "stats")]
+use alloc::boxed::Box;
 use alloc::{string::String, vec::Vec};
 use core::cmp::min;
 use core::convert::TryFrom;
@@ -5,12 +7,15 @@ use ttf_parser::GlyphId;
 
 use super::buffer::glyph_flag::{SAFE_TO_INSERT_TATWEEL, UNSAFE_TO_BREAK, UNSAFE_TO_CONCAT};
 use super::face::hb_glyph_extents_t;
-use super::unicode::{CharExt, GeneralCategoryExt};
+use super::unicode::CharExt;
+use super::unicode_props::unicode_props;
 use super::{hb_font_t, hb_mask_t};
-use crate::hb::set_digest::{hb_set_digest_ext, hb_set_digest_t};
+use crate::hb::set_digest::hb_set_digest_t;
+#[cfg(feature = "stats")]
+use crate::hb::stats::ShapingStats;
 use crate::{script, BufferClusterLevel, BufferFlags, Direction, Language, Script, SerializeFlags};
 
-const CONTEXT_LENGTH: usize = 5;
+pub(crate) const CONTEXT_LENGTH: usize = 5;
 
 pub mod glyph_flag {
     /// Indicates that if input text is broken at the
@@ -193,6 +198,15 @@ impl hb_glyph_info_t {
         self.mask & glyph_flag::UNSAFE_TO_BREAK != 0
     }
 
+    /// Indicates that if input text is changed on one side of the beginning of the cluster
+    /// this glyph is part of, then the shaping results for the other side might change.
+    ///
+    /// Only produced when the buffer has [`BufferFlags::PRODUCE_UNSAFE_TO_CONCAT`] set.
+    /// [`unsafe_to_break`](Self::unsafe_to_break) always implies this flag.
+    pub fn unsafe_to_concat(&self) -> bool {
+        self.mask & glyph_flag::UNSAFE_TO_CONCAT != 0
+    }
+
     #[inline]
     pub(crate) fn as_char(&self) -> char {
         char::try_from(self.glyph_id).unwrap()
@@ -234,48 +248,18 @@ impl hb_glyph_info_t {
 
     pub(crate) fn init_unicode_props(&mut self, scratch_flags: &mut hb_buffer_scratch_flags_t) {
         let u = self.as_char();
-        let gc = u.general_category();
-        let mut props = gc.to_rb() as u16;
+        let props = unicode_props(u);
 
         if u as u32 >= 0x80 {
             *scratch_flags |= HB_BUFFER_SCRATCH_FLAG_HAS_NON_ASCII;
 
-            if u.is_default_ignorable() {
-                props |= UnicodeProps::IGNORABLE.bits();
+            if props & UnicodeProps::IGNORABLE.bits() != 0 {
                 *scratch_flags |= HB_BUFFER_SCRATCH_FLAG_HAS_DEFAULT_IGNORABLES;
 
-                match u as u32 {
-                    0x200C => props |= UnicodeProps::CF_ZWNJ.bits(),
-                    0x200D => props |= UnicodeProps::CF_ZWJ.bits(),
-
-                    // Mongolian Free Variation Selectors need to be remembered
-                    // because although we need to hide them like default-ignorables,
-                    // they need to non-ignorable during shaping.  This is similar to
-                    // what we do for joiners in Indic-like shapers, but since the
-                    // FVSes are GC=Mn, we have use a separate bit to remember them.
-                    // Fixes:
-                    // https://github.com/harfbuzz/harfbuzz/issues/234
-                    0x180B..=0x180D | 0x180F => props |= UnicodeProps::HIDDEN.bits(),
-
-                    // TAG characters need similar treatment. Fixes:
-                    // https://github.com/harfbuzz/harfbuzz/issues/463
-                    0xE0020..=0xE007F => props |= UnicodeProps::HIDDEN.bits(),
-
-                    // COMBINING GRAPHEME JOINER should not be skipped; at least some times.
-                    // https://github.com/harfbuzz/harfbuzz/issues/554
-                    0x034F => {
-                        props |= UnicodeProps::HIDDEN.bits();
-                        *scratch_flags |= HB_BUFFER_SCRATCH_FLAG_HAS_CGJ;
-                    }
-
-                    _ => {}
+                if u == '\u{034F}' {
+                    *scratch_flags |= HB_BUFFER_SCRATCH_FLAG_HAS_CGJ;
                 }
             }
-
-            if gc.is_mark() {
-                props |= UnicodeProps::CONTINUATION.bits();
-                props |= (u.modified_combining_class() as u16) << 8;
-            }
         }
 
         self.set_unicode_props(props);
@@ -349,6 +333,7 @@ pub const HB_BUFFER_CLUSTER_LEVEL_MONOTONE_CHARACTERS: u32 = 1;
 pub const HB_BUFFER_CLUSTER_LEVEL_CHARACTERS: u32 = 2;
 pub const HB_BUFFER_CLUSTER_LEVEL_DEFAULT: u32 = HB_BUFFER_CLUSTER_LEVEL_MONOTONE_GRAPHEMES;
 
+#[derive(Clone)]
 pub struct hb_buffer_t {
     // Information about how the text in the buffer should be treated.
     pub flags: BufferFlags,
@@ -391,6 +376,9 @@ pub struct hb_buffer_t {
     pub max_len: usize,
     /// Maximum allowed operations.
     pub max_ops: i32,
+
+    #[cfg(feature = "stats")]
+    pub(crate) stats: Option<Box<ShapingStats>>,
 }
 
 impl hb_buffer_t {
@@ -432,6 +420,8 @@ impl hb_buffer_t {
                 ['\0', '\0', '\0', '\0', '\0'],
             ],
             context_len: [0, 0],
+            #[cfg(feature = "stats")]
+            stats: None,
         }
     }
 
@@ -493,12 +483,10 @@ impl hb_buffer_t {
     }
 
     pub fn digest(&self) -> hb_set_digest_t {
-        let mut digest = hb_set_digest_t::new();
-        digest.add_array(self.info.iter().map(|i| GlyphId(i.glyph_id as u16)));
-        digest
+        hb_set_digest_t::from_glyphs(&self.info[..self.len], |info| info.glyph_id)
     }
 
-    fn clear(&mut self) {
+    pub(crate) fn clear(&mut self) {
         self.direction = Direction::Invalid;
         self.script = None;
         self.language = None;
@@ -708,9 +696,7 @@ impl hb_buffer_t {
         self.out_len = 0;
         self.have_separate_output = false;
 
-        for pos in &mut self.pos {
-            *pos = GlyphPosition::default();
-        }
+        self.pos[..self.len].fill(GlyphPosition::default());
     }
 
     pub fn replace_glyphs(&mut self, num_in: usize, num_out: usize, glyph_data: &[u32]) {
@@ -863,10 +849,16 @@ impl hb_buffer_t {
             return;
         }
 
+        if cluster_start >= cluster_end {
+            return;
+        }
+
+        // Branchless, so that the loop can be vectorized.
+        let cluster_len = cluster_end - cluster_start;
         for info in &mut self.info[..self.len] {
-            if cluster_start <= info.cluster && info.cluster < cluster_end {
-                info.mask = (info.mask & not_mask) | value;
-            }
+            let inside = info.cluster.wrapping_sub(cluster_start) < cluster_len;
+            let select = hb_mask_t::from(inside).wrapping_neg();
+            info.mask = (info.mask & !(mask & select)) | (value & select);
         }
     }
 
@@ -1434,6 +1426,20 @@ impl hb_buffer_t {
         }
     }
 
+    /// Pushes `text[range]`, using the rest of `text` as context.
+    ///
+    /// Cluster values are byte offsets into the whole `text`.
+    pub(crate) fn push_str_item(&mut self, text: &str, range: core::ops::Range<usize>) {
+        self.set_pre_context(&text[..range.start]);
+        self.set_post_context(&text[range.end..]);
+
+        let item = &text[range.start..range.end];
+        self.ensure(self.len + item.len());
+        for (i, c) in item.char_indices() {
+            self.add(c as u32, (range.start + i) as u32);
+        }
+    }
+
     fn set_pre_context(&mut self, text: &str) {
         self.clear_context(0);
         for (i, c) in text.chars().rev().enumerate().take(CONTEXT_LENGTH) {
@@ -1673,6 +1679,19 @@ impl UnicodeBuffer {
         self.0.flags
     }
 
+    /// Enables or disables collecting [`ShapingStats`] when shaping this buffer.
+    ///
+    /// The statistics of the last shaping call are available from [`GlyphBuffer::stats`].
+    #[cfg(feature = "stats")]
+    #[inline]
+    pub fn set_collect_stats(&mut self, enabled: bool) {
+        match (enabled, self.0.stats.is_some()) {
+            (true, false) => self.0.stats = Some(Box::default()),
+            (false, true) => self.0.stats = None,
+            _ => {}
+        }
+    }
+
     /// Set the cluster level of the buffer.
     #[inline]
     pub fn set_cluster_level(&mut self, cluster_level: BufferClusterLevel) {
@@ -1756,6 +1775,14 @@ impl GlyphBuffer {
         &self.0.pos[0..self.0.len]
     }
 
+    /// Returns the statistics of the shaping call that produced this buffer,
+    /// if enabled with [`UnicodeBuffer::set_collect_stats`].
+    #[cfg(feature = "stats")]
+    #[inline]
+    pub fn stats(&self) -> Option<&ShapingStats> {
+        self.0.stats.as_deref()
+    }
+
     /// Clears the content of the glyph buffer and returns an empty
     /// `UnicodeBuffer` reusing the existing allocation.
     #[inline]
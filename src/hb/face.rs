@@ -1,18 +1,213 @@
 #[cfg(not(feature = "std"))]
 use core_maths::CoreFloat;
 
+use alloc::boxed::Box;
+use alloc::sync::Arc;
+use core::sync::atomic::{AtomicU32, Ordering};
+
 use crate::hb::paint_extents::hb_paint_extents_context_t;
 use ttf_parser::gdef::GlyphClass;
 use ttf_parser::opentype_layout::LayoutTable;
 use ttf_parser::{GlyphId, RgbaColor};
 
+use super::aat_layout_common::hb_aat_class_cache_t;
 use super::buffer::GlyphPropsFlags;
 use super::fonta;
+use super::fonta::once_cell::OnceCell;
+use super::kerning::hb_kern_pair_cache_t;
 use super::ot_layout::TableIndex;
 use super::ot_layout_common::{PositioningTable, SubstitutionTable};
+use super::ot_shape_plan::hb_shape_plan_cache_t;
 use crate::Variation;
 
+pub use super::fonta::CharSet;
+
+/// Size- and variation-independent data of a font face.
+///
+/// Parsing it is expensive, so it is shared between all clones of a [`hb_font_t`].
+pub(crate) struct hb_face_data_t<'a> {
+    pub(crate) gsub: Option<SubstitutionTable<'a>>,
+    pub(crate) gpos: Option<PositioningTable<'a>>,
+    // Plans are keyed by variation coordinates, so clones can share them.
+    pub(crate) plan_cache: hb_shape_plan_cache_t,
+    // Compiled `Wasm` table and its host functions, `None` if the face has none.
+    #[cfg(feature = "wasm-shaper")]
+    pub(crate) wasm_shaper: OnceCell<Option<super::shape_wasm::hb_wasm_shaper_t>>,
+    // GDEF glyph props indexed by glyph id, empty if the face has no glyph classes.
+    glyph_props: OnceCell<Box<[u16]>>,
+    // Glyph classes of the AAT state machine subtables.
+    pub(crate) aat_classes: hb_aat_class_cache_t,
+    // Decoded pairs of the `kern` format 0 subtables.
+    pub(crate) kern_pairs: hb_kern_pair_cache_t,
+}
+
+impl<'a> hb_face_data_t<'a> {
+    fn new(face: &ttf_parser::Face<'a>) -> Self {
+        hb_face_data_t {
+            gsub: face.tables().gsub.map(SubstitutionTable::new),
+            gpos: face.tables().gpos.map(PositioningTable::new),
+            plan_cache: hb_shape_plan_cache_t::default(),
+            #[cfg(feature = "wasm-shaper")]
+            wasm_shaper: OnceCell::new(),
+            glyph_props: OnceCell::new(),
+            aat_classes: hb_aat_class_cache_t::default(),
+            kern_pairs: hb_kern_pair_cache_t::default(),
+        }
+    }
+}
+
+// Glyphs past this are rare in running text and not worth the memory.
+const HB_ADVANCE_CACHE_MAX_GLYPHS: u16 = 8192;
+const HB_ADVANCE_CACHE_EMPTY: u32 = u32::MAX;
+
+/// Lazily filled advances of a font instance, indexed by glyph id.
+///
+/// Depends on the variation coordinates, so it must be cleared whenever they change.
+#[derive(Default)]
+pub(crate) struct hb_advance_cache_t {
+    h_advances: OnceCell<Box<[AtomicU32]>>,
+    v_advances: OnceCell<Box<[AtomicU32]>>,
+}
+
+impl hb_advance_cache_t {
+    fn get_or_insert(
+        &self,
+        glyph: GlyphId,
+        is_vertical: bool,
+        num_glyphs: u16,
+        f: impl FnOnce() -> u32,
+    ) -> u32 {
+        let len = num_glyphs.min(HB_ADVANCE_CACHE_MAX_GLYPHS) as usize;
+        let index = usize::from(glyph.0);
+        if index >= len {
+            return f();
+        }
+
+        let cell = if is_vertical {
+            &self.v_advances
+        } else {
+            &self.h_advances
+        };
+        let advances = cell.get_or_init(|| {
+            (0..len)
+                .map(|_| AtomicU32::new(HB_ADVANCE_CACHE_EMPTY))
+                .collect()
+        });
+
+        let entry = &advances[index];
+        match entry.load(Ordering::Relaxed) {
+            HB_ADVANCE_CACHE_EMPTY => {
+                // An advance equal to the sentinel is simply never cached.
+                let advance = f();
+                entry.store(advance, Ordering::Relaxed);
+                advance
+            }
+            advance => advance,
+        }
+    }
+
+    fn clear(&mut self) {
+        *self = Self::default();
+    }
+}
+
+impl Clone for hb_advance_cache_t {
+    // Clones usually get different variations, so start over.
+    fn clone(&self) -> Self {
+        Self::default()
+    }
+}
+
+// Glyphs of an extents cache block, one bit each in the block masks.
+const HB_EXTENTS_CACHE_BLOCK_LEN: usize = 32;
+
+#[derive(Default)]
+struct hb_extents_cache_block_t {
+    // Glyphs whose entry has been written.
+    ready: AtomicU32,
+    // Glyphs for which `hb_font_t::glyph_extents` returns `true`.
+    found: AtomicU32,
+    extents: [[AtomicU32; 4]; HB_EXTENTS_CACHE_BLOCK_LEN],
+}
+
+/// Lazily filled glyph extents of a font instance, indexed by glyph id.
+///
+/// Computing them may mean traversing a whole `COLR` paint graph, so they are
+/// worth keeping. Memory is allocated in blocks of glyphs, on first use.
+///
+/// Depends on the variation coordinates and the pixels per EM, so it must be
+/// cleared whenever they change.
+#[derive(Default)]
+pub(crate) struct hb_extents_cache_t {
+    blocks: OnceCell<Box<[OnceCell<Box<hb_extents_cache_block_t>>]>>,
+}
+
+impl hb_extents_cache_t {
+    fn get_or_insert(
+        &self,
+        glyph: GlyphId,
+        num_glyphs: u16,
+        f: impl FnOnce() -> (bool, hb_glyph_extents_t),
+    ) -> (bool, hb_glyph_extents_t) {
+        let len = num_glyphs.min(HB_ADVANCE_CACHE_MAX_GLYPHS) as usize;
+        let index = usize::from(glyph.0);
+        if index >= len {
+            return f();
+        }
+
+        let blocks = self.blocks.get_or_init(|| {
+            (0..len.div_ceil(HB_EXTENTS_CACHE_BLOCK_LEN))
+                .map(|_| OnceCell::new())
+                .collect()
+        });
+        let block = blocks[index / HB_EXTENTS_CACHE_BLOCK_LEN].get_or_init(Box::default);
+        let bit = 1 << (index % HB_EXTENTS_CACHE_BLOCK_LEN);
+        let entry = &block.extents[index % HB_EXTENTS_CACHE_BLOCK_LEN];
+
+        if block.ready.load(Ordering::Acquire) & bit != 0 {
+            let value = |i: usize| entry[i].load(Ordering::Relaxed) as i32;
+            let extents = hb_glyph_extents_t {
+                x_bearing: value(0),
+                y_bearing: value(1),
+                width: value(2),
+                height: value(3),
+            };
+            return (block.found.load(Ordering::Relaxed) & bit != 0, extents);
+        }
+
+        // Concurrent writers of an entry compute the same extents,
+        // so interleaved stores are harmless.
+        let (found, e) = f();
+        for (value, e) in entry
+            .iter()
+            .zip([e.x_bearing, e.y_bearing, e.width, e.height])
+        {
+            value.store(e as u32, Ordering::Relaxed);
+        }
+        if found {
+            block.found.fetch_or(bit, Ordering::Relaxed);
+        }
+        block.ready.fetch_or(bit, Ordering::Release);
+        (found, e)
+    }
+
+    fn clear(&mut self) {
+        *self = Self::default();
+    }
+}
+
+impl Clone for hb_extents_cache_t {
+    // Same as for the advance cache.
+    fn clone(&self) -> Self {
+        Self::default()
+    }
+}
+
 /// A font face handle.
+///
+/// Cloning a face is cheap: the parsed layout tables are shared between clones,
+/// so creating another instance of a face with a different size or different
+/// variations via [`Clone`] doesn't parse the font again.
 #[derive(Clone)]
 pub struct hb_font_t<'a> {
     pub(crate) ttfp_face: ttf_parser::Face<'a>,
@@ -20,8 +215,10 @@ pub struct hb_font_t<'a> {
     pub(crate) units_per_em: u16,
     pixels_per_em: Option<(u16, u16)>,
     pub(crate) points_per_em: Option<f32>,
-    pub(crate) gsub: Option<SubstitutionTable<'a>>,
-    pub(crate) gpos: Option<PositioningTable<'a>>,
+    pub(crate) face_data: Arc<hb_face_data_t<'a>>,
+    advance_cache: hb_advance_cache_t,
+    extents_cache: hb_extents_cache_t,
+    pub(crate) pair_pos_cache: bool,
 }
 
 impl<'a> AsRef<ttf_parser::Face<'a>> for hb_font_t<'a> {
@@ -34,6 +231,9 @@ impl<'a> AsRef<ttf_parser::Face<'a>> for hb_font_t<'a> {
 impl<'a> AsMut<ttf_parser::Face<'a>> for hb_font_t<'a> {
     #[inline]
     fn as_mut(&mut self) -> &mut ttf_parser::Face<'a> {
+        // Variations may be changed through the returned reference.
+        self.advance_cache.clear();
+        self.extents_cache.clear();
         &mut self.ttfp_face
     }
 }
@@ -50,6 +250,9 @@ impl<'a> core::ops::Deref for hb_font_t<'a> {
 impl<'a> core::ops::DerefMut for hb_font_t<'a> {
     #[inline]
     fn deref_mut(&mut self) -> &mut Self::Target {
+        // Variations may be changed through the returned reference.
+        self.advance_cache.clear();
+        self.extents_cache.clear();
         &mut self.ttfp_face
     }
 }
@@ -66,8 +269,10 @@ impl<'a> hb_font_t<'a> {
             units_per_em: face.units_per_em(),
             pixels_per_em: None,
             points_per_em: None,
-            gsub: face.tables().gsub.map(SubstitutionTable::new),
-            gpos: face.tables().gpos.map(PositioningTable::new),
+            face_data: Arc::new(hb_face_data_t::new(&face)),
+            advance_cache: hb_advance_cache_t::default(),
+            extents_cache: hb_extents_cache_t::default(),
+            pair_pos_cache: false,
             ttfp_face: face,
         })
     }
@@ -82,8 +287,10 @@ impl<'a> hb_font_t<'a> {
             units_per_em: face.units_per_em(),
             pixels_per_em: None,
             points_per_em: None,
-            gsub: face.tables().gsub.map(SubstitutionTable::new),
-            gpos: face.tables().gpos.map(PositioningTable::new),
+            face_data: Arc::new(hb_face_data_t::new(&face)),
+            advance_cache: hb_advance_cache_t::default(),
+            extents_cache: hb_extents_cache_t::default(),
+            pair_pos_cache: false,
             ttfp_face: face,
         }
     }
@@ -107,6 +314,10 @@ impl<'a> hb_font_t<'a> {
     /// `None` by default.
     #[inline]
     pub fn set_pixels_per_em(&mut self, ppem: Option<(u16, u16)>) {
+        if self.pixels_per_em != ppem {
+            // Raster glyph extents depend on the selected strike.
+            self.extents_cache.clear();
+        }
         self.pixels_per_em = ppem;
     }
 
@@ -120,14 +331,38 @@ impl<'a> hb_font_t<'a> {
         self.points_per_em = ptem;
     }
 
+    /// Enables the pair matrix cache for class-based kerning.
+    ///
+    /// When enabled, the value records of frequently applied `PairPosFormat2`
+    /// subtables are decoded once into a class-pair matrix, so positioning a pair
+    /// costs two class lookups and an array index. The matrices are shared by all
+    /// clones of the face and use at most 1 MiB per face.
+    ///
+    /// `false` by default.
+    #[inline]
+    pub fn set_pair_pos_cache(&mut self, enabled: bool) {
+        self.pair_pos_cache = enabled;
+    }
+
     /// Sets font variations.
     pub fn set_variations(&mut self, variations: &[Variation]) {
         for variation in variations {
-            self.set_variation(variation.tag, variation.value);
+            self.ttfp_face.set_variation(variation.tag, variation.value);
         }
+        self.advance_cache.clear();
+        self.extents_cache.clear();
         self.font.set_coords(self.ttfp_face.variation_coordinates());
     }
 
+    /// Returns the set of codepoints that the face maps to a glyph.
+    ///
+    /// The set is built from the character map on first use and shared by all clones
+    /// of the face. Testing it is much cheaper than looking up every character,
+    /// which makes it suitable for picking fallback fonts.
+    pub fn char_set(&self) -> &CharSet {
+        self.font.char_set()
+    }
+
     pub(crate) fn has_glyph(&self, c: u32) -> bool {
         self.get_nominal_glyph(c).is_some()
     }
@@ -153,6 +388,15 @@ impl<'a> hb_font_t<'a> {
     }
 
     fn glyph_advance(&self, glyph: GlyphId, is_vertical: bool) -> u32 {
+        self.advance_cache.get_or_insert(
+            glyph,
+            is_vertical,
+            self.ttfp_face.number_of_glyphs(),
+            || self.glyph_advance_uncached(glyph, is_vertical),
+        )
+    }
+
+    fn glyph_advance_uncached(&self, glyph: GlyphId, is_vertical: bool) -> u32 {
         let face = &self.ttfp_face;
         if face.is_variable()
             && face.has_non_default_variation_coordinates()
@@ -231,6 +475,23 @@ impl<'a> hb_font_t<'a> {
         &self,
         glyph: GlyphId,
         glyph_extents: &mut hb_glyph_extents_t,
+    ) -> bool {
+        // A failed `COLR` paint still sets the extents, so keep them either way.
+        let (found, extents) =
+            self.extents_cache
+                .get_or_insert(glyph, self.ttfp_face.number_of_glyphs(), || {
+                    let mut extents = hb_glyph_extents_t::default();
+                    let found = self.glyph_extents_uncached(glyph, &mut extents);
+                    (found, extents)
+                });
+        *glyph_extents = extents;
+        found
+    }
+
+    fn glyph_extents_uncached(
+        &self,
+        glyph: GlyphId,
+        glyph_extents: &mut hb_glyph_extents_t,
     ) -> bool {
         let pixels_per_em = match self.pixels_per_em {
             Some(ppem) => ppem.0,
@@ -320,7 +581,34 @@ impl<'a> hb_font_t<'a> {
         self.ttfp_face.glyph_name(glyph)
     }
 
+    /// Returns the GDEF glyph props of `glyph`.
+    ///
+    /// Props of all glyphs are collected on first use, since buffers look them
+    /// up for every glyph.
+    #[inline]
     pub(crate) fn glyph_props(&self, glyph: GlyphId) -> u16 {
+        match self.glyph_props_table().get(usize::from(glyph.0)) {
+            Some(props) => *props,
+            None => self.glyph_props_uncached(glyph),
+        }
+    }
+
+    /// Returns the props of all glyphs, indexed by glyph id.
+    ///
+    /// Empty if the font has no glyph classes, in which case all props are zero.
+    #[inline]
+    pub(crate) fn glyph_props_table(&self) -> &[u16] {
+        self.face_data
+            .glyph_props
+            .get_or_init(|| match self.tables().gdef {
+                Some(table) if table.has_glyph_classes() => (0..self.number_of_glyphs())
+                    .map(|glyph| self.glyph_props_uncached(GlyphId(glyph)))
+                    .collect(),
+                _ => Box::default(),
+            })
+    }
+
+    fn glyph_props_uncached(&self, glyph: GlyphId) -> u16 {
         let table = match self.tables().gdef {
             Some(v) => v,
             None => return 0,
@@ -339,8 +627,8 @@ impl<'a> hb_font_t<'a> {
 
     pub(crate) fn layout_table(&self, table_index: TableIndex) -> Option<&LayoutTable<'a>> {
         match table_index {
-            TableIndex::GSUB => self.gsub.as_ref().map(|table| &table.inner),
-            TableIndex::GPOS => self.gpos.as_ref().map(|table| &table.inner),
+            TableIndex::GSUB => self.face_data.gsub.as_ref().map(|table| &table.inner),
+            TableIndex::GPOS => self.face_data.gpos.as_ref().map(|table| &table.inner),
         }
     }
 
@@ -351,6 +639,92 @@ impl<'a> hb_font_t<'a> {
     }
 }
 
+/// A [`Face`](crate::Face) that owns its font data.
+///
+/// Unlike `Face`, it has no lifetime, so it can be kept in `'static` caches and
+/// shared between threads. The data can be anything that gives access to the font
+/// bytes and doesn't move them, like a `Vec<u8>`, an `Arc<[u8]>` or a memory-mapped
+/// file. With a memory-mapped file, only the pages of the tables that are actually
+/// used become resident.
+///
+/// Cloning is cheap: the data and the parsed tables are shared between clones.
+#[derive(Clone)]
+pub struct OwnedFace {
+    // Borrows from `data`, so it must be dropped first.
+    face: hb_font_t<'static>,
+    data: Arc<dyn AsRef<[u8]> + Send + Sync>,
+}
+
+impl OwnedFace {
+    /// Creates a new `OwnedFace` from data.
+    ///
+    /// `data` must return the same bytes every time it's asked for them.
+    pub fn from_data(
+        data: impl AsRef<[u8]> + Send + Sync + 'static,
+        face_index: u32,
+    ) -> Option<Self> {
+        Self::from_arc(Arc::new(data), face_index)
+    }
+
+    /// Creates a new `OwnedFace` from shared data.
+    ///
+    /// `data` must return the same bytes every time it's asked for them.
+    pub fn from_arc(data: Arc<dyn AsRef<[u8]> + Send + Sync>, face_index: u32) -> Option<Self> {
+        let bytes = (*data).as_ref();
+        // SAFETY: `data` keeps the bytes alive and in place for as long as `face`
+        // exists, and `face` is only handed out with the lifetime of `self`.
+        let bytes: &'static [u8] =
+            unsafe { core::slice::from_raw_parts(bytes.as_ptr(), bytes.len()) };
+        let face = hb_font_t::from_slice(bytes, face_index)?;
+        Some(OwnedFace { face, data })
+    }
+
+    /// Returns the face.
+    #[inline]
+    pub fn face(&self) -> &hb_font_t<'_> {
+        // SAFETY: only shortens the lifetime. The lazily parsed parts of the face make
+        // `hb_font_t` invariant, but they are only ever filled from the face's own data.
+        unsafe { core::mem::transmute::<&hb_font_t<'static>, &hb_font_t<'_>>(&self.face) }
+    }
+
+    /// Returns the font data.
+    #[inline]
+    pub fn data(&self) -> &[u8] {
+        (*self.data).as_ref()
+    }
+
+    /// Sets pixels per EM, see [`Face::set_pixels_per_em`](crate::Face::set_pixels_per_em).
+    #[inline]
+    pub fn set_pixels_per_em(&mut self, ppem: Option<(u16, u16)>) {
+        self.face.set_pixels_per_em(ppem);
+    }
+
+    /// Sets point size per EM, see [`Face::set_points_per_em`](crate::Face::set_points_per_em).
+    #[inline]
+    pub fn set_points_per_em(&mut self, ptem: Option<f32>) {
+        self.face.set_points_per_em(ptem);
+    }
+
+    /// Enables the pair matrix cache, see [`Face::set_pair_pos_cache`](crate::Face::set_pair_pos_cache).
+    #[inline]
+    pub fn set_pair_pos_cache(&mut self, enabled: bool) {
+        self.face.set_pair_pos_cache(enabled);
+    }
+
+    /// Sets font variations, see [`Face::set_variations`](crate::Face::set_variations).
+    pub fn set_variations(&mut self, variations: &[Variation]) {
+        self.face.set_variations(variations);
+    }
+}
+
+impl core::fmt::Debug for OwnedFace {
+    fn fmt(&self, f: &mut core::fmt::Formatter<'_>) -> core::fmt::Result {
+        f.debug_struct("OwnedFace")
+            .field("len", &self.data().len())
+            .finish()
+    }
+}
+
 #[derive(Clone, Copy, Default)]
 #[repr(C)]
 pub struct hb_glyph_extents_t {
@@ -362,3 +736,25 @@ pub struct hb_glyph_extents_t {
 
 unsafe impl bytemuck::Zeroable for hb_glyph_extents_t {}
 unsafe impl bytemuck::Pod for hb_glyph_extents_t {}
+
+#[cfg(test)]
+mod tests {
+    #[test]
+    fn test_owned_face_is_send_sync_and_static() {
+        fn ensure_send_sync_and_static<T: Send + Sync + 'static>() {}
+        ensure_send_sync_and_static::<super::OwnedFace>();
+    }
+
+    #[test]
+    #[cfg(target_pointer_width = "64")]
+    fn test_face_size() {
+        // Parsed tables and caches live behind the shared face data or on the heap,
+        // a face only adds a few handles to the `ttf_parser` face: the `fonta` font
+        // (96 bytes: tables, coordinates, variation store, region scalars and the
+        // delta cache), the advance and extents caches (72 bytes), the shared face
+        // data and the size and flag fields.
+        let overhead =
+            core::mem::size_of::<super::hb_font_t>() - core::mem::size_of::<ttf_parser::Face>();
+        assert!(overhead <= 200, "{} bytes", overhead);
+    }
+}
@@ -0,0 +1,190 @@
+use alloc::boxed::Box;
+use alloc::vec;
+use alloc::vec::Vec;
+
+// Codepoints are grouped in pages of 512, like in HarfBuzz's `hb_set_t`.
+const PAGE_BITS: u32 = 9;
+const PAGE_LEN: u32 = 1 << PAGE_BITS;
+const PAGE_WORDS: usize = (PAGE_LEN / 64) as usize;
+const PAGE_COUNT: usize = (0x10FFFF >> PAGE_BITS) + 1;
+
+// Pages shared by all blocks that are not covered at all and fully covered.
+const EMPTY_PAGE: u16 = 0;
+const FULL_PAGE: u16 = 1;
+
+type Page = [u64; PAGE_WORDS];
+
+/// An immutable set of the codepoints mapped by the character map of a face.
+///
+/// Stored as a sparse bitmap: every block of 512 codepoints points to a page of bits,
+/// with all empty and all full blocks sharing the same page. Lookups are two loads
+/// and a bit test, without searching the `cmap` table.
+///
+/// Returned by [`Face::char_set`](crate::Face::char_set).
+#[derive(Clone)]
+pub struct CharSet {
+    page_map: Box<[u16]>,
+    pages: Vec<Page>,
+    len: usize,
+    // Copy of the first page bits, since most text is ASCII.
+    ascii: u128,
+}
+
+impl CharSet {
+    pub(crate) fn new() -> Self {
+        CharSet {
+            page_map: vec![EMPTY_PAGE; PAGE_COUNT].into_boxed_slice(),
+            pages: vec![[0; PAGE_WORDS], [u64::MAX; PAGE_WORDS]],
+            len: 0,
+            ascii: 0,
+        }
+    }
+
+    // Returns the page of the block of `c`, allocating it.
+    fn page_mut(&mut self, c: u32) -> &mut Page {
+        let block = (c >> PAGE_BITS) as usize;
+        if self.page_map[block] == EMPTY_PAGE {
+            self.page_map[block] = self.pages.len() as u16;
+            self.pages.push([0; PAGE_WORDS]);
+        }
+        &mut self.pages[usize::from(self.page_map[block])]
+    }
+
+    /// Inserts a codepoint, ignoring codepoints past U+10FFFF.
+    pub(crate) fn insert(&mut self, c: u32) {
+        if c > 0x10FFFF || self.page_map[(c >> PAGE_BITS) as usize] == FULL_PAGE {
+            return;
+        }
+
+        let bit = c % PAGE_LEN;
+        let word = &mut self.page_mut(c)[(bit / 64) as usize];
+        let mask = 1 << (bit % 64);
+        if *word & mask == 0 {
+            *word |= mask;
+            self.len += 1;
+        }
+        if c < 128 {
+            self.ascii |= 1 << c;
+        }
+    }
+
+    /// Inserts an inclusive range of codepoints, ignoring codepoints past U+10FFFF.
+    pub(crate) fn insert_range(&mut self, start: u32, end: u32) {
+        let end = end.min(0x10FFFF);
+        let mut c = start;
+        while c <= end {
+            let block_end = c | (PAGE_LEN - 1);
+            if c % PAGE_LEN == 0 && block_end <= end {
+                // Whole blocks share the full page.
+                let block = (c >> PAGE_BITS) as usize;
+                let page = self.page_map[block];
+                if page != FULL_PAGE {
+                    let count: u32 = self.pages[usize::from(page)]
+                        .iter()
+                        .map(|word| word.count_ones())
+                        .sum();
+                    self.len += (PAGE_LEN - count) as usize;
+                    self.page_map[block] = FULL_PAGE;
+                    if block == 0 {
+                        self.ascii = u128::MAX;
+                    }
+                }
+            } else {
+                for c in c..=block_end.min(end) {
+                    self.insert(c);
+                }
+            }
+
+            match block_end.checked_add(1) {
+                Some(next) => c = next,
+                None => break,
+            }
+        }
+    }
+
+    /// Returns `true` if the face maps `c` to a glyph.
+    #[inline]
+    pub fn contains(&self, c: char) -> bool {
+        let c = c as u32;
+        if c < 128 {
+            return self.ascii & (1 << c) != 0;
+        }
+
+        let page = &self.pages[usize::from(self.page_map[(c >> PAGE_BITS) as usize])];
+        let bit = c % PAGE_LEN;
+        page[(bit / 64) as usize] & (1 << (bit % 64)) != 0
+    }
+
+    /// Returns the number of codepoints in the set.
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    /// Returns `true` if the face maps no codepoint.
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    /// Returns the byte offset of the first character of `text` that is not in the set,
+    /// or `None` if the face covers the whole text.
+    ///
+    /// This is what font fallback needs to split text into runs that a face can
+    /// render. ASCII is tested eight bytes at a time.
+    pub fn first_uncovered(&self, text: &str) -> Option<usize> {
+        let bytes = text.as_bytes();
+        let mut i = 0;
+        while i < bytes.len() {
+            if let Some(chunk) = bytes.get(i..i + 8) {
+                let word = u64::from_le_bytes(chunk.try_into().unwrap());
+                if word & 0x8080_8080_8080_8080 == 0 {
+                    let mut covered = true;
+                    for &byte in chunk {
+                        covered &= self.ascii & (1 << byte) != 0;
+                    }
+                    if covered {
+                        i += 8;
+                        continue;
+                    }
+                }
+            }
+
+            let c = text[i..].chars().next().unwrap();
+            if !self.contains(c) {
+                return Some(i);
+            }
+            i += c.len_utf8();
+        }
+
+        None
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::CharSet;
+
+    #[test]
+    fn insert_and_query() {
+        let mut set = CharSet::new();
+        set.insert(0x41);
+        set.insert(0x41);
+        set.insert(0x3B1);
+        set.insert_range(0x4E00, 0x9FFF);
+        set.insert_range(0x10FF00, u32::MAX);
+
+        assert_eq!(set.len(), 2 + (0x9FFF - 0x4E00 + 1) + 0x100);
+        assert!(set.contains('A'));
+        assert!(!set.contains('B'));
+        assert!(set.contains('α'));
+        assert!(set.contains('\u{4E00}') && set.contains('\u{9FFF}'));
+        assert!(!set.contains('\u{4DFF}') && !set.contains('\u{A000}'));
+        assert!(set.contains('\u{10FFFF}'));
+
+        assert_eq!(set.first_uncovered("AAAAAAAAAAAAα一"), None);
+        assert_eq!(set.first_uncovered("AAAAAAAAAB"), Some(9));
+        assert_eq!(set.first_uncovered("AAα€"), Some(4));
+        assert_eq!(set.first_uncovered(""), None);
+    }
+}
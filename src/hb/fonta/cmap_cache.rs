@@ -0,0 +1,168 @@
+use super::once_cell::OnceCell;
+#[cfg(target_has_atomic = "64")]
+use core::sync::atomic::AtomicU64;
+use core::sync::atomic::{AtomicU32, Ordering};
+use skrifa::{charmap::MapVariant, GlyphId};
+
+// Codepoints below this are mapped through a flat table.
+const FLAT_LEN: usize = 0x100;
+const FLAT_NOT_MAPPED: u32 = u32::MAX;
+
+// Direct-mapped cache for the remaining codepoints, same layout as
+// HarfBuzz's `hb_cache_t<21, 16, 8>`: the entry at `c & 0xFF` stores
+// the rest of the 21 codepoint bits above a 16-bit glyph id.
+const CACHE_BITS: u32 = 8;
+const CACHE_VALUE_BITS: u32 = 16;
+const CACHE_EMPTY: u32 = u32::MAX;
+
+// Same for (codepoint, variation selector) pairs, keyed by the codepoint
+// and the selector index. A separate flag bit says "use the default glyph".
+#[cfg(target_has_atomic = "64")]
+const VARIANT_CACHE_BITS: u32 = 6;
+#[cfg(target_has_atomic = "64")]
+const VARIANT_USE_DEFAULT: u64 = 1 << CACHE_VALUE_BITS;
+#[cfg(target_has_atomic = "64")]
+const VARIANT_CACHE_EMPTY: u64 = u64::MAX;
+
+/// Lookup caches for a character map.
+///
+/// Only successful lookups are stored, since those are what running text needs.
+pub struct CmapCache {
+    flat: OnceCell<[u32; FLAT_LEN]>,
+    entries: [AtomicU32; 1 << CACHE_BITS],
+    #[cfg(target_has_atomic = "64")]
+    variants: [AtomicU64; 1 << VARIANT_CACHE_BITS],
+}
+
+impl CmapCache {
+    pub fn new() -> Self {
+        Self {
+            flat: OnceCell::new(),
+            entries: core::array::from_fn(|_| AtomicU32::new(CACHE_EMPTY)),
+            #[cfg(target_has_atomic = "64")]
+            variants: core::array::from_fn(|_| AtomicU64::new(VARIANT_CACHE_EMPTY)),
+        }
+    }
+
+    /// Returns the glyph for `c`, calling `map` on a cache miss.
+    #[inline]
+    pub fn get_or_insert(&self, c: u32, map: impl Fn(u32) -> Option<GlyphId>) -> Option<GlyphId> {
+        if (c as usize) < FLAT_LEN {
+            let flat = self.flat.get_or_init(|| {
+                core::array::from_fn(|c| map(c as u32).map_or(FLAT_NOT_MAPPED, |gid| gid.to_u32()))
+            });
+            return match flat[c as usize] {
+                FLAT_NOT_MAPPED => None,
+                gid => Some(GlyphId::new(gid)),
+            };
+        }
+
+        if c > 0x10FFFF {
+            return map(c);
+        }
+
+        let entry = &self.entries[(c & ((1 << CACHE_BITS) - 1)) as usize];
+        let key = c >> CACHE_BITS;
+        let value = entry.load(Ordering::Relaxed);
+        if value != CACHE_EMPTY && value >> CACHE_VALUE_BITS == key {
+            return Some(GlyphId::new(value & ((1 << CACHE_VALUE_BITS) - 1)));
+        }
+
+        let gid = map(c)?;
+        if gid.to_u32() < (1 << CACHE_VALUE_BITS) {
+            entry.store(key << CACHE_VALUE_BITS | gid.to_u32(), Ordering::Relaxed);
+        }
+        Some(gid)
+    }
+
+    /// Returns the format 14 mapping of `c` followed by `vs`, calling `map` on a cache miss.
+    #[inline]
+    pub fn get_or_insert_variant(
+        &self,
+        c: u32,
+        vs: u32,
+        map: impl FnOnce() -> Option<MapVariant>,
+    ) -> Option<MapVariant> {
+        #[cfg(target_has_atomic = "64")]
+        if let Some(vs_index) = variation_selector_index(vs).filter(|_| c <= 0x10FFFF) {
+            let entry = &self.variants[(c & ((1 << VARIANT_CACHE_BITS) - 1)) as usize];
+            let key = u64::from(c) << 8 | u64::from(vs_index);
+            let value = entry.load(Ordering::Relaxed);
+            if value != VARIANT_CACHE_EMPTY && value >> 32 == key {
+                return Some(if value & VARIANT_USE_DEFAULT != 0 {
+                    MapVariant::UseDefault
+                } else {
+                    MapVariant::Variant(GlyphId::new(
+                        (value & ((1 << CACHE_VALUE_BITS) - 1)) as u32,
+                    ))
+                });
+            }
+
+            let result = map()?;
+            let value = match result {
+                MapVariant::UseDefault => Some(VARIANT_USE_DEFAULT),
+                MapVariant::Variant(gid) if gid.to_u32() < (1 << CACHE_VALUE_BITS) => {
+                    Some(u64::from(gid.to_u32()))
+                }
+                MapVariant::Variant(_) => None,
+            };
+            if let Some(value) = value {
+                entry.store(key << 32 | value, Ordering::Relaxed);
+            }
+            return Some(result);
+        }
+
+        map()
+    }
+}
+
+impl Default for CmapCache {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl Clone for CmapCache {
+    fn clone(&self) -> Self {
+        Self::new()
+    }
+}
+
+// Maps the 256 standard variation selectors to 0..=255.
+#[cfg(target_has_atomic = "64")]
+fn variation_selector_index(vs: u32) -> Option<u8> {
+    match vs {
+        0xFE00..=0xFE0F => Some((vs - 0xFE00) as u8),
+        0xE0100..=0xE01EF => Some((vs - 0xE0100 + 16) as u8),
+        _ => None,
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn cache_hits_and_collisions() {
+        let cache = CmapCache::new();
+        let map = |c: u32| (c != 0x42 && c != 0x142).then(|| GlyphId::new(c & 0xFFFF));
+        for c in [0x41, 0x42, 0xFF, 0x141, 0x142, 0x241, 0x1F600] {
+            assert_eq!(cache.get_or_insert(c, map), map(c));
+        }
+
+        // Hits don't call `map` again, 0x241 replaced 0x141 in the same slot.
+        assert_eq!(
+            cache.get_or_insert(0x41, |_| None),
+            Some(GlyphId::new(0x41))
+        );
+        assert_eq!(
+            cache.get_or_insert(0x241, |_| None),
+            Some(GlyphId::new(0x241))
+        );
+        assert_eq!(
+            cache.get_or_insert(0x1F600, |_| None),
+            Some(GlyphId::new(0xF600))
+        );
+        assert_eq!(cache.get_or_insert(0x141, |_| None), None);
+    }
+}
@@ -0,0 +1,97 @@
+#[cfg(target_has_atomic = "64")]
+use super::once_cell::OnceCell;
+#[cfg(target_has_atomic = "64")]
+use alloc::boxed::Box;
+#[cfg(target_has_atomic = "64")]
+use core::sync::atomic::{AtomicU64, Ordering};
+
+// Direct-mapped cache of computed deltas: the entry at the low bits of
+// the hashed delta set index stores the index above the 32-bit delta.
+#[cfg(target_has_atomic = "64")]
+const CACHE_BITS: u32 = 8;
+#[cfg(target_has_atomic = "64")]
+const CACHE_EMPTY: u64 = u64::MAX;
+
+/// Cache of the item variation deltas of a font instance, keyed by delta set index.
+///
+/// Only valid for a single set of variation coordinates. The entries are allocated
+/// on first use, so instances without variations don't pay for them.
+pub struct DeltaCache {
+    #[cfg(target_has_atomic = "64")]
+    entries: OnceCell<Box<[AtomicU64; 1 << CACHE_BITS]>>,
+}
+
+impl DeltaCache {
+    pub fn new() -> Self {
+        Self {
+            #[cfg(target_has_atomic = "64")]
+            entries: OnceCell::new(),
+        }
+    }
+
+    /// Returns the delta of the set `outer`/`inner`, calling `compute` on a cache miss.
+    #[inline]
+    pub fn get_or_insert(&self, outer: u16, inner: u16, compute: impl FnOnce() -> i32) -> i32 {
+        #[cfg(target_has_atomic = "64")]
+        {
+            let key = u32::from(outer) << 16 | u32::from(inner);
+            // Neighbouring inner indices of the same outer index are the common case.
+            let hash = key ^ (key >> 16).wrapping_mul(0x9E37);
+            let entries = self
+                .entries
+                .get_or_init(|| Box::new(core::array::from_fn(|_| AtomicU64::new(CACHE_EMPTY))));
+            let entry = &entries[(hash & ((1 << CACHE_BITS) - 1)) as usize];
+            let value = entry.load(Ordering::Relaxed);
+            if value != CACHE_EMPTY && (value >> 32) as u32 == key {
+                return value as u32 as i32;
+            }
+
+            let delta = compute();
+            let value = u64::from(key) << 32 | u64::from(delta as u32);
+            if value != CACHE_EMPTY {
+                entry.store(value, Ordering::Relaxed);
+            }
+            delta
+        }
+
+        #[cfg(not(target_has_atomic = "64"))]
+        {
+            let _ = (outer, inner);
+            compute()
+        }
+    }
+}
+
+impl Default for DeltaCache {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl Clone for DeltaCache {
+    // Clones usually get different variations, so start over.
+    fn clone(&self) -> Self {
+        Self::new()
+    }
+}
+
+#[cfg(all(test, target_has_atomic = "64"))]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn cache_hits_and_collisions() {
+        let cache = DeltaCache::new();
+        let compute = |outer: u16, inner: u16| i32::from(outer) * 1000 - i32::from(inner);
+        for (outer, inner) in [(0, 0), (0, 1), (1, 0), (0, 256), (3, 7), (0xFFFF, 0xFFFF)] {
+            assert_eq!(
+                cache.get_or_insert(outer, inner, || compute(outer, inner)),
+                compute(outer, inner)
+            );
+        }
+
+        // Hits don't compute again.
+        assert_eq!(cache.get_or_insert(3, 7, || 0), compute(3, 7));
+        assert_eq!(cache.get_or_insert(0, 1, || 0), compute(0, 1));
+    }
+}
@@ -1,4 +1,9 @@
+use super::char_set::CharSet;
+use super::cmap_cache::CmapCache;
+use super::delta_cache::DeltaCache;
+use super::once_cell::OnceCell;
 use super::ot;
+use alloc::sync::Arc;
 use alloc::vec::Vec;
 use skrifa::{
     charmap::MapVariant,
@@ -7,7 +12,7 @@ use skrifa::{
         tables::{
             cmap::{Cmap, Cmap14, CmapSubtable, PlatformId},
             gpos::{AnchorTable, DeviceOrVariationIndex},
-            variations::{DeltaSetIndex, ItemVariationStore},
+            variations::ItemVariationStore,
         },
         ReadError, TableProvider,
     },
@@ -30,12 +35,23 @@ const UNICODE_2_0_FULL_ENCODING: u16 = 4;
 //const UNICODE_VARIATION_ENCODING: u16 = 5;
 const UNICODE_FULL_ENCODING: u16 = 6;
 
-#[derive(Clone)]
-pub struct Font<'a> {
+/// Parsed tables that don't depend on the font instance.
+pub struct FontTables<'a> {
     pub charmap: Charmap<'a>,
     pub ot: ot::LayoutTables<'a>,
+}
+
+/// A font instance.
+///
+/// Cloning is cheap, since the parsed tables are shared between clones.
+#[derive(Clone)]
+pub struct Font<'a> {
+    pub tables: Arc<FontTables<'a>>,
     pub coords: Vec<NormalizedCoord>,
     pub ivs: Option<ItemVariationStore<'a>>,
+    // Scalars of the variation regions of `ivs` at `coords`, as 16.16 fixed-point bits.
+    region_scalars: Vec<i32>,
+    delta_cache: DeltaCache,
 }
 
 impl<'a> Font<'a> {
@@ -44,23 +60,41 @@ impl<'a> Font<'a> {
         let charmap = Charmap::new(&font);
         let ot = ot::LayoutTables::new(&font);
         Some(Self {
-            charmap,
-            ot,
+            tables: Arc::new(FontTables { charmap, ot }),
             coords: Vec::new(),
             ivs: None,
+            region_scalars: Vec::new(),
+            delta_cache: DeltaCache::new(),
         })
     }
 
     pub(crate) fn set_coords(&mut self, coords: &[NormalizedCoordinate]) {
         self.coords.clear();
+        self.region_scalars.clear();
+        self.delta_cache = DeltaCache::new();
         if !coords.is_empty() && !coords.iter().all(|coord| coord.get() == 0) {
-            let ivs = self.ivs.take().or_else(|| self.ot.item_variation_store());
-            if ivs.is_some() {
+            let ivs = self
+                .ivs
+                .take()
+                .or_else(|| self.tables.ot.item_variation_store());
+            if let Some(ivs) = ivs.as_ref() {
                 self.coords.extend(
                     coords
                         .iter()
                         .map(|coord| NormalizedCoord::from_bits(coord.get())),
                 );
+
+                // Every delta set refers to some of the regions, so evaluate them
+                // once for the instance instead of for every delta.
+                if let Ok(regions) = ivs.variation_region_list() {
+                    let coords = &self.coords;
+                    self.region_scalars.extend(
+                        regions
+                            .variation_regions()
+                            .iter()
+                            .map(|region| region.map_or(0, |r| r.compute_scalar(coords).to_bits())),
+                    );
+                }
             }
             self.ivs = ivs;
         } else {
@@ -68,20 +102,40 @@ impl<'a> Font<'a> {
         }
     }
 
+    /// Returns the delta of a delta set of the item variation store, or 0 if
+    /// the font has no variations.
+    #[inline]
+    pub(crate) fn delta(&self, outer: u16, inner: u16) -> i32 {
+        match self.ivs.as_ref() {
+            Some(ivs) => self.delta_cache.get_or_insert(outer, inner, || {
+                self.compute_delta(ivs, outer, inner).unwrap_or_default()
+            }),
+            None => 0,
+        }
+    }
+
+    // Same as `ItemVariationStore::compute_delta`, with the precomputed region scalars.
+    fn compute_delta(&self, ivs: &ItemVariationStore<'a>, outer: u16, inner: u16) -> Option<i32> {
+        let data = ivs.item_variation_data().get(usize::from(outer))?.ok()?;
+        let region_indices = data.region_indexes();
+        // Compute deltas with 64-bit precision, like FreeType and skrifa.
+        let mut accum = 0i64;
+        for (i, region_delta) in data.delta_set(inner).enumerate() {
+            let region_index = usize::from(region_indices.get(i)?.get());
+            let scalar = *self.region_scalars.get(region_index)?;
+            accum += i64::from(region_delta) * i64::from(scalar);
+        }
+        Some(((accum + 0x8000) >> 16) as i32)
+    }
+
     pub(super) fn resolve_anchor(&self, anchor: &AnchorTable) -> (i32, i32) {
         let mut x = anchor.x_coordinate() as i32;
         let mut y = anchor.y_coordinate() as i32;
-        if let Some(ivs) = self.ivs.as_ref() {
+        if self.ivs.is_some() {
             let delta = |val: Option<Result<DeviceOrVariationIndex<'_>, ReadError>>| match val {
-                Some(Ok(DeviceOrVariationIndex::VariationIndex(varix))) => ivs
-                    .compute_delta(
-                        DeltaSetIndex {
-                            outer: varix.delta_set_outer_index(),
-                            inner: varix.delta_set_inner_index(),
-                        },
-                        &self.coords,
-                    )
-                    .unwrap_or_default(),
+                Some(Ok(DeviceOrVariationIndex::VariationIndex(varix))) => {
+                    self.delta(varix.delta_set_outer_index(), varix.delta_set_inner_index())
+                }
                 _ => 0,
             };
             x += delta(anchor.x_device());
@@ -90,8 +144,15 @@ impl<'a> Font<'a> {
         (x, y)
     }
 
-    pub fn nominal_glyph(&self, mut c: u32) -> Option<GlyphId> {
-        let subtable = self.charmap.subtable.as_ref()?;
+    pub fn nominal_glyph(&self, c: u32) -> Option<GlyphId> {
+        self.tables
+            .charmap
+            .cache
+            .get_or_insert(c, |c| self.nominal_glyph_uncached(c))
+    }
+
+    fn nominal_glyph_uncached(&self, mut c: u32) -> Option<GlyphId> {
+        let subtable = self.tables.charmap.subtable.as_ref()?;
         if subtable.0 == PlatformId::Macintosh && c > 0x7F {
             c = unicode_to_macroman(c);
         }
@@ -128,14 +189,96 @@ impl<'a> Font<'a> {
             // Windows seems to do, and that's hinted about at:
             // https://docs.microsoft.com/en-us/typography/opentype/spec/recom
             // under "Non-Standard (Symbol) Fonts".
-            return self.nominal_glyph(0xF000 + c);
+            return self.nominal_glyph_uncached(0xF000 + c);
         }
         result
     }
 
+    /// Returns the set of codepoints mapped by the character map, built on first use.
+    pub fn char_set(&self) -> &CharSet {
+        self.tables
+            .charmap
+            .char_set
+            .get_or_init(|| self.build_char_set())
+    }
+
+    fn build_char_set(&self) -> CharSet {
+        let mut set = CharSet::new();
+        let Some(subtable) = self.tables.charmap.subtable.as_ref() else {
+            return set;
+        };
+
+        // Every candidate is checked with the lookup itself, so that the set agrees
+        // with `nominal_glyph`, including the symbol and MacRoman remappings.
+        // Like in HarfBuzz, characters mapped to glyph 0 are not covered, which
+        // matters for the array formats that have an entry for every character.
+        let maps = |c: u32| {
+            self.nominal_glyph_uncached(c)
+                .map_or(false, |gid| gid.to_u32() != 0)
+        };
+        let mut check = |c: u32| {
+            if maps(c) {
+                set.insert(c);
+            }
+        };
+        if subtable.0 == PlatformId::Macintosh {
+            (0..0x80).for_each(&mut check);
+            UNICODE_TO_MACROMAN
+                .iter()
+                .for_each(|c| check(u32::from(*c)));
+            return set;
+        }
+        if subtable.0 == PlatformId::Windows && subtable.1 == WINDOWS_SYMBOL_ENCODING {
+            (0..=0xFF).for_each(&mut check);
+        }
+
+        match &subtable.2 {
+            CmapSubtable::Format0(table) => {
+                (0..table.glyph_id_array().len() as u32).for_each(check);
+            }
+            CmapSubtable::Format6(table) => {
+                let first = u32::from(table.first_code());
+                (first..first + table.glyph_id_array().len() as u32).for_each(check);
+            }
+            CmapSubtable::Format10(table) => {
+                let first = table.start_char_code();
+                let len = table.glyph_id_array().len() as u32;
+                (first..first.saturating_add(len)).for_each(check);
+            }
+            CmapSubtable::Format4(table) => {
+                for (start, end) in table.start_code().iter().zip(table.end_code()) {
+                    (u32::from(start.get())..=u32::from(end.get())).for_each(&mut check);
+                }
+            }
+            CmapSubtable::Format12(table) => {
+                for group in table.groups() {
+                    let start = group.start_char_code();
+                    let end = group.end_char_code();
+                    if start > end {
+                        continue;
+                    }
+                    // Groups map consecutive glyphs, only the first one can be glyph 0.
+                    if maps(start) {
+                        set.insert(start);
+                    }
+                    if start < end && maps(start + 1) {
+                        set.insert_range(start + 1, end);
+                    }
+                }
+            }
+            _ => {}
+        }
+        set
+    }
+
     pub fn nominal_variant_glyph(&self, c: u32, vs: u32) -> Option<GlyphId> {
-        let subtable = self.charmap.vs_subtable.as_ref()?;
-        match subtable.map_variant(c, vs)? {
+        let subtable = self.tables.charmap.vs_subtable.as_ref()?;
+        let variant = self
+            .tables
+            .charmap
+            .cache
+            .get_or_insert_variant(c, vs, || subtable.map_variant(c, vs))?;
+        match variant {
             MapVariant::UseDefault => self.nominal_glyph(c),
             MapVariant::Variant(gid) => Some(gid),
         }
@@ -146,6 +289,8 @@ impl<'a> Font<'a> {
 pub struct Charmap<'a> {
     subtable: Option<(PlatformId, u16, CmapSubtable<'a>)>,
     vs_subtable: Option<Cmap14<'a>>,
+    cache: CmapCache,
+    char_set: OnceCell<CharSet>,
 }
 
 impl<'a> Charmap<'a> {
@@ -165,6 +310,8 @@ impl<'a> Charmap<'a> {
             return Self {
                 subtable,
                 vs_subtable,
+                cache: CmapCache::new(),
+                char_set: OnceCell::new(),
             };
         }
         Self::default()
@@ -1,6 +1,11 @@
 pub mod ot;
 
+mod char_set;
+mod cmap_cache;
+mod delta_cache;
 mod font;
+pub mod once_cell;
 mod set_digest;
 
+pub use char_set::CharSet;
 pub use font::Font;
@@ -0,0 +1,135 @@
+use core::cell::UnsafeCell;
+use core::mem::MaybeUninit;
+use core::sync::atomic::{AtomicU8, Ordering};
+
+const EMPTY: u8 = 0;
+const RUNNING: u8 = 1;
+const READY: u8 = 2;
+
+/// A thread-safe cell which can be written to only once.
+///
+/// Similar to `std::sync::OnceLock`, but available without `std`. Threads
+/// racing on initialization spin until the winner has stored its value, so
+/// the initializer should be short (parsing a single table entry and alike).
+pub struct OnceCell<T> {
+    state: AtomicU8,
+    value: UnsafeCell<MaybeUninit<T>>,
+}
+
+// Same bounds as `std::sync::OnceLock`.
+unsafe impl<T: Send + Sync> Sync for OnceCell<T> {}
+unsafe impl<T: Send> Send for OnceCell<T> {}
+
+impl<T> OnceCell<T> {
+    /// Creates a new empty cell.
+    pub const fn new() -> Self {
+        Self {
+            state: AtomicU8::new(EMPTY),
+            value: UnsafeCell::new(MaybeUninit::uninit()),
+        }
+    }
+
+    /// Returns the value, if it was already initialized.
+    #[inline]
+    pub fn get(&self) -> Option<&T> {
+        if self.state.load(Ordering::Acquire) == READY {
+            // SAFETY: `READY` is only stored after the value was written
+            // and the value is never modified afterwards.
+            Some(unsafe { (*self.value.get()).assume_init_ref() })
+        } else {
+            None
+        }
+    }
+
+    /// Returns the value, initializing it with `f` if the cell was empty.
+    ///
+    /// If several threads call this concurrently, only one `f` is executed.
+    #[inline]
+    pub fn get_or_init(&self, f: impl FnOnce() -> T) -> &T {
+        if let Some(value) = self.get() {
+            return value;
+        }
+
+        self.initialize(f)
+    }
+
+    #[cold]
+    fn initialize(&self, f: impl FnOnce() -> T) -> &T {
+        let mut f = Some(f);
+        loop {
+            match self.state.compare_exchange_weak(
+                EMPTY,
+                RUNNING,
+                Ordering::Acquire,
+                Ordering::Acquire,
+            ) {
+                Ok(_) => {
+                    // Let other threads retry if `f` panics.
+                    let reset = ResetOnUnwind(&self.state);
+                    let value = (f.take().unwrap())();
+                    // SAFETY: we are the only thread in the `RUNNING` state.
+                    unsafe { (*self.value.get()).write(value) };
+                    core::mem::forget(reset);
+                    self.state.store(READY, Ordering::Release);
+                }
+                Err(READY) => {}
+                Err(_) => {
+                    core::hint::spin_loop();
+                    continue;
+                }
+            }
+
+            // SAFETY: the state is `READY` at this point.
+            return unsafe { (*self.value.get()).assume_init_ref() };
+        }
+    }
+}
+
+impl<T> Default for OnceCell<T> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl<T: Clone> Clone for OnceCell<T> {
+    fn clone(&self) -> Self {
+        let cell = Self::new();
+        if let Some(value) = self.get() {
+            // SAFETY: the cell is not shared yet.
+            unsafe { (*cell.value.get()).write(value.clone()) };
+            cell.state.store(READY, Ordering::Relaxed);
+        }
+        cell
+    }
+}
+
+impl<T> Drop for OnceCell<T> {
+    fn drop(&mut self) {
+        if *self.state.get_mut() == READY {
+            // SAFETY: the value was initialized and we have exclusive access.
+            unsafe { self.value.get_mut().assume_init_drop() };
+        }
+    }
+}
+
+struct ResetOnUnwind<'a>(&'a AtomicU8);
+
+impl Drop for ResetOnUnwind<'_> {
+    fn drop(&mut self) {
+        self.0.store(EMPTY, Ordering::Release);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::OnceCell;
+
+    #[test]
+    fn init_once() {
+        let cell = OnceCell::new();
+        assert_eq!(cell.get(), None);
+        assert_eq!(*cell.get_or_init(|| 1), 1);
+        assert_eq!(*cell.get_or_init(|| 2), 1);
+        assert_eq!(cell.clone().get(), Some(&1));
+    }
+}
@@ -0,0 +1,41 @@
+use core::sync::atomic::{AtomicUsize, Ordering};
+
+/// Memory budget shared by the lazily built caches of a face.
+pub struct CacheBudget {
+    capacity: usize,
+    remaining: AtomicUsize,
+}
+
+impl CacheBudget {
+    pub fn new(bytes: usize) -> Self {
+        Self {
+            capacity: bytes,
+            remaining: AtomicUsize::new(bytes),
+        }
+    }
+
+    /// Takes `bytes` from the budget, if they are available.
+    pub fn reserve(&self, bytes: usize) -> bool {
+        self.remaining
+            .fetch_update(Ordering::Relaxed, Ordering::Relaxed, |remaining| {
+                remaining.checked_sub(bytes)
+            })
+            .is_ok()
+    }
+
+    /// Gives back `bytes` taken by `reserve`.
+    pub fn release(&self, bytes: usize) {
+        self.remaining.fetch_add(bytes, Ordering::Relaxed);
+    }
+
+    pub fn remaining(&self) -> usize {
+        self.remaining.load(Ordering::Relaxed)
+    }
+}
+
+// The caches are not cloned, so neither is the budget spent on them.
+impl Clone for CacheBudget {
+    fn clone(&self) -> Self {
+        Self::new(self.capacity)
+    }
+}
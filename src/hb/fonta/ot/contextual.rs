@@ -1,6 +1,7 @@
+use crate::hb::fonta::ot::ApplyCovered;
 use crate::hb::ot_layout_gsubgpos::OT::hb_ot_apply_context_t;
 use crate::hb::ot_layout_gsubgpos::{
-    apply_lookup, match_backtrack, match_func_t, match_glyph, match_input, match_lookahead, Apply,
+    apply_lookup, match_backtrack, match_func_t, match_glyph, match_input, match_lookahead,
     WouldApply, WouldApplyContext,
 };
 use skrifa::raw::tables::layout::{
@@ -15,11 +16,12 @@ impl WouldApply for ChainedSequenceContextFormat1<'_> {
     }
 }
 
-impl Apply for ChainedSequenceContextFormat1<'_> {
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t) -> Option<()> {
-        let glyph = skrifa::GlyphId::from(ctx.buffer.cur(0).as_glyph().0);
-        let index = self.coverage().ok()?.get(glyph)? as usize;
-        let set = self.chained_seq_rule_sets().get(index)?.ok()?;
+impl ApplyCovered for ChainedSequenceContextFormat1<'_> {
+    fn apply_covered(&self, ctx: &mut hb_ot_apply_context_t, coverage_index: u16) -> Option<()> {
+        let set = self
+            .chained_seq_rule_sets()
+            .get(coverage_index as usize)?
+            .ok()?;
         for rule in set.chained_seq_rules().iter().filter_map(|rule| rule.ok()) {
             let backtrack = rule.backtrack_sequence();
             let input = rule.input_sequence();
@@ -29,7 +31,7 @@ impl Apply for ChainedSequenceContextFormat1<'_> {
                 backtrack,
                 input,
                 lookahead,
-                [&match_glyph; 3],
+                (&match_glyph, &match_glyph, &match_glyph),
                 rule.seq_lookup_records()
                     .iter()
                     .map(|rec| SequenceLookupRecord {
@@ -64,13 +66,12 @@ fn match_class<'a>(
     }
 }
 
-impl Apply for ChainedSequenceContextFormat2<'_> {
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t) -> Option<()> {
+impl ApplyCovered for ChainedSequenceContextFormat2<'_> {
+    fn apply_covered(&self, ctx: &mut hb_ot_apply_context_t, _: u16) -> Option<()> {
         let backtrack_classes = self.backtrack_class_def().ok();
         let input_classes = self.input_class_def().ok();
         let lookahead_classes = self.lookahead_class_def().ok();
         let glyph = ctx.buffer.cur(0).as_skrifa_glyph16();
-        self.coverage().ok()?.get(glyph)?;
         let index = input_classes.as_ref()?.get(glyph) as usize;
         let set = self.chained_class_seq_rule_sets().get(index)?.ok()?;
         for rule in set
@@ -86,11 +87,11 @@ impl Apply for ChainedSequenceContextFormat2<'_> {
                 backtrack,
                 input,
                 lookahead,
-                [
+                (
                     &match_class(&backtrack_classes),
                     &match_class(&input_classes),
                     &match_class(&lookahead_classes),
-                ],
+                ),
                 rule.seq_lookup_records()
                     .iter()
                     .map(|rec| SequenceLookupRecord {
@@ -125,12 +126,9 @@ impl WouldApply for ChainedSequenceContextFormat3<'_> {
     }
 }
 
-impl Apply for ChainedSequenceContextFormat3<'_> {
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t) -> Option<()> {
-        let glyph = skrifa::GlyphId::from(ctx.buffer.cur(0).as_glyph().0);
-
+impl ApplyCovered for ChainedSequenceContextFormat3<'_> {
+    fn apply_covered(&self, ctx: &mut hb_ot_apply_context_t, _: u16) -> Option<()> {
         let input_coverages = self.input_coverages();
-        input_coverages.get(0).ok()?.get(glyph)?;
 
         let backtrack_coverages = self.backtrack_coverages();
         let lookahead_coverages = self.lookahead_coverages();
@@ -240,24 +238,24 @@ fn apply_chain_context<T: ToU16>(
     backtrack: &[T],
     input: &[T],
     lookahead: &[T],
-    match_funcs: [&match_func_t; 3],
+    match_funcs: (&impl match_func_t, &impl match_func_t, &impl match_func_t),
     lookups: impl Iterator<Item = SequenceLookupRecord>,
 ) -> Option<()> {
     // NOTE: Whenever something in this method changes, we also need to
     // change it in the `apply` implementation for ChainedContextLookup.
-    let f1 = |glyph, index| {
+    let f1 = |glyph: GlyphId, index: u16| {
         let value = (*backtrack.get(index as usize).unwrap()).to_u16();
-        match_funcs[0](glyph, value)
+        (match_funcs.0)(glyph, value)
     };
 
-    let f2 = |glyph, index| {
+    let f2 = |glyph: GlyphId, index: u16| {
         let value = (*lookahead.get(index as usize).unwrap()).to_u16();
-        match_funcs[2](glyph, value)
+        (match_funcs.2)(glyph, value)
     };
 
-    let f3 = |glyph, index| {
+    let f3 = |glyph: GlyphId, index: u16| {
         let value = (*input.get(index as usize).unwrap()).to_u16();
-        match_funcs[1](glyph, value)
+        (match_funcs.1)(glyph, value)
     };
 
     let mut end_index = ctx.buffer.idx;
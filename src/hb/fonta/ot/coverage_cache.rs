@@ -0,0 +1,226 @@
+use super::cache_budget::CacheBudget;
+use crate::hb::fonta::once_cell::OnceCell;
+use alloc::boxed::Box;
+use alloc::vec::Vec;
+use core::sync::atomic::{AtomicU32, Ordering};
+use skrifa::raw::tables::layout::CoverageTable;
+
+/// Number of coverage queries a subtable answers by binary search before
+/// an accelerator is built for it.
+const HOT_THRESHOLD: u32 = 64;
+
+/// Coverage tables with fewer glyphs than this are cheap enough to search.
+const MIN_GLYPHS: usize = 16;
+
+/// Memory available for the coverage accelerators of a single face, in bytes.
+pub const DEFAULT_BUDGET: usize = 256 * 1024;
+
+/// Coverage as a dense bitset over the covered glyph range, with the number of
+/// covered glyphs preceding each 64-bit word.
+///
+/// The coverage index of a glyph is its rank in the set, so a lookup is a
+/// bit test and a popcount.
+pub struct CoverageAccelerator {
+    first: u32,
+    words: Box<[u64]>,
+    ranks: Box<[u16]>,
+}
+
+impl CoverageAccelerator {
+    fn new(coverage: &CoverageTable, budget: &CacheBudget) -> Option<Self> {
+        let (first, last, count) = match coverage {
+            CoverageTable::Format1(table) => {
+                let glyphs = table.glyph_array();
+                let first = glyphs.first()?.get().to_u32();
+                let last = glyphs.last()?.get().to_u32();
+                (first, last, glyphs.len())
+            }
+            CoverageTable::Format2(table) => {
+                let ranges = table.range_records();
+                let first = ranges.first()?.start_glyph_id().to_u32();
+                let last = ranges.last()?.end_glyph_id().to_u32();
+                let count = ranges
+                    .iter()
+                    .map(|range| {
+                        let start = range.start_glyph_id().to_u32();
+                        let end = range.end_glyph_id().to_u32();
+                        end.saturating_sub(start) as usize + 1
+                    })
+                    .sum();
+                (first, last, count)
+            }
+        };
+        if count < MIN_GLYPHS || last < first {
+            return None;
+        }
+
+        let word_count = (last - first) as usize / 64 + 1;
+        let size = word_count * (core::mem::size_of::<u64>() + core::mem::size_of::<u16>());
+        if !budget.reserve(size) {
+            return None;
+        }
+
+        let accelerator = Self::build(coverage, first, word_count);
+        if accelerator.is_none() {
+            budget.release(size);
+        }
+        accelerator
+    }
+
+    // Returns `None` if the coverage indices are not the ranks of the glyphs,
+    // which only happens for malformed tables.
+    fn build(coverage: &CoverageTable, first: u32, word_count: usize) -> Option<Self> {
+        let mut words = Vec::new();
+        words.resize(word_count, 0u64);
+        let mut expected_index = 0u32;
+        let mut prev_glyph = None;
+        let mut insert = |glyph: u32, index: u32| {
+            if index != expected_index || prev_glyph.map_or(false, |prev| glyph <= prev) {
+                return None;
+            }
+            let bit = glyph.checked_sub(first)? as usize;
+            *words.get_mut(bit / 64)? |= 1 << (bit % 64);
+            expected_index += 1;
+            prev_glyph = Some(glyph);
+            Some(())
+        };
+
+        match coverage {
+            CoverageTable::Format1(table) => {
+                for (index, glyph) in table.glyph_array().iter().enumerate() {
+                    insert(glyph.get().to_u32(), index as u32)?;
+                }
+            }
+            CoverageTable::Format2(table) => {
+                for range in table.range_records() {
+                    let start = range.start_glyph_id().to_u32();
+                    let end = range.end_glyph_id().to_u32();
+                    let start_index = u32::from(range.start_coverage_index());
+                    for glyph in start..=end {
+                        insert(glyph, start_index + glyph - start)?;
+                    }
+                }
+            }
+        }
+
+        let mut rank = 0u32;
+        let ranks = words
+            .iter()
+            .map(|word| {
+                let word_rank = rank as u16;
+                rank += word.count_ones();
+                word_rank
+            })
+            .collect();
+
+        Some(Self {
+            first,
+            words: words.into_boxed_slice(),
+            ranks,
+        })
+    }
+
+    #[inline]
+    pub fn get(&self, glyph: u32) -> Option<u16> {
+        let bit = glyph.checked_sub(self.first)? as usize;
+        let word = *self.words.get(bit / 64)?;
+        let mask = 1u64 << (bit % 64);
+        if word & mask == 0 {
+            return None;
+        }
+        Some(self.ranks[bit / 64] + (word & (mask - 1)).count_ones() as u16)
+    }
+}
+
+/// Per-subtable state for accelerating primary coverage lookups.
+///
+/// An accelerator is only built once the subtable has been queried often
+/// enough to pay for it, and only while the budget of the face allows.
+#[derive(Default)]
+pub struct CoverageCache {
+    queries: AtomicU32,
+    accelerator: OnceCell<Option<CoverageAccelerator>>,
+}
+
+impl CoverageCache {
+    /// Returns the accelerator, building it if the subtable turned hot.
+    #[inline]
+    pub fn accelerator<'a>(
+        &self,
+        coverage: impl FnOnce() -> Option<CoverageTable<'a>>,
+        budget: &CacheBudget,
+    ) -> Option<&CoverageAccelerator> {
+        if let Some(accelerator) = self.accelerator.get() {
+            return accelerator.as_ref();
+        }
+        if self.queries.fetch_add(1, Ordering::Relaxed) < HOT_THRESHOLD {
+            return None;
+        }
+        self.accelerator
+            .get_or_init(|| CoverageAccelerator::new(&coverage()?, budget))
+            .as_ref()
+    }
+}
+
+impl Clone for CoverageCache {
+    fn clone(&self) -> Self {
+        Self::default()
+    }
+}
+
+impl core::fmt::Debug for CoverageCache {
+    fn fmt(&self, f: &mut core::fmt::Formatter<'_>) -> core::fmt::Result {
+        f.debug_struct("CoverageCache")
+            .field(
+                "accelerated",
+                &self.accelerator.get().map_or(false, Option::is_some),
+            )
+            .finish()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use skrifa::raw::{FontData, FontRead};
+
+    // Format 2 with the ranges 10..=40 and 200..=210.
+    const COVERAGE: &[u8] = &[
+        0, 2, 0, 2, //
+        0, 10, 0, 40, 0, 0, //
+        0, 200, 0, 210, 0, 31,
+    ];
+
+    fn coverage() -> CoverageTable<'static> {
+        CoverageTable::read(FontData::new(COVERAGE)).unwrap()
+    }
+
+    #[test]
+    fn matches_coverage_table() {
+        let budget = CacheBudget::new(DEFAULT_BUDGET);
+        let table = coverage();
+        let accelerator = CoverageAccelerator::new(&table, &budget).unwrap();
+        for glyph in 0..300u32 {
+            assert_eq!(
+                accelerator.get(glyph),
+                table.get(skrifa::GlyphId::new(glyph)),
+                "glyph {}",
+                glyph
+            );
+        }
+    }
+
+    #[test]
+    fn respects_budget() {
+        let budget = CacheBudget::new(16);
+        assert!(CoverageAccelerator::new(&coverage(), &budget).is_none());
+
+        let cache = CoverageCache::default();
+        let budget = CacheBudget::new(DEFAULT_BUDGET);
+        for _ in 0..HOT_THRESHOLD {
+            assert!(cache.accelerator(|| Some(coverage()), &budget).is_none());
+        }
+        assert!(cache.accelerator(|| Some(coverage()), &budget).is_some());
+        assert!(budget.remaining() < DEFAULT_BUDGET);
+    }
+}
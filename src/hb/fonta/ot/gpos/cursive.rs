@@ -1,20 +1,20 @@
 use crate::hb::buffer::HB_BUFFER_SCRATCH_FLAG_HAS_GPOS_ATTACHMENT;
+use crate::hb::fonta::ot::ApplyCovered;
 use crate::hb::ot_layout_common::lookup_flags;
 use crate::hb::ot_layout_gpos_table::attach_type;
+use crate::hb::ot_layout_gsubgpos::skipping_iterator_t;
 use crate::hb::ot_layout_gsubgpos::OT::hb_ot_apply_context_t;
-use crate::hb::ot_layout_gsubgpos::{skipping_iterator_t, Apply};
 use crate::{Direction, GlyphPosition};
 use skrifa::raw::tables::gpos::CursivePosFormat1;
 
-impl Apply for CursivePosFormat1<'_> {
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t) -> Option<()> {
-        let this = ctx.buffer.cur(0).as_skrifa_glyph();
-
-        let coverage = self.coverage().ok()?;
-        let index_this = coverage.get(this)? as usize;
+impl ApplyCovered for CursivePosFormat1<'_> {
+    fn apply_covered(&self, ctx: &mut hb_ot_apply_context_t, index_this: u16) -> Option<()> {
         let records = self.entry_exit_record();
         let offset_data = self.offset_data();
-        let entry_this = records.get(index_this)?.entry_anchor(offset_data)?.ok()?;
+        let entry_this = records
+            .get(index_this as usize)?
+            .entry_anchor(offset_data)?
+            .ok()?;
 
         let mut iter = skipping_iterator_t::new(ctx, ctx.buffer.idx, false);
 
@@ -27,7 +27,7 @@ impl Apply for CursivePosFormat1<'_> {
 
         let i = iter.index();
         let prev = ctx.buffer.info[i].as_skrifa_glyph();
-        let index_prev = coverage.get(prev)? as usize;
+        let index_prev = self.coverage().ok()?.get(prev)? as usize;
         let Some(exit_prev) = records
             .get(index_prev)
             .and_then(|rec| rec.exit_anchor(offset_data).transpose().ok().flatten())
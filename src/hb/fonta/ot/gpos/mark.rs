@@ -1,4 +1,5 @@
 use crate::hb::buffer::{hb_buffer_t, HB_BUFFER_SCRATCH_FLAG_HAS_GPOS_ATTACHMENT};
+use crate::hb::fonta::ot::ApplyCovered;
 use crate::hb::ot_layout::{
     _hb_glyph_info_get_lig_comp, _hb_glyph_info_get_lig_id, _hb_glyph_info_is_mark,
     _hb_glyph_info_multiplied,
@@ -6,7 +7,7 @@ use crate::hb::ot_layout::{
 use crate::hb::ot_layout_common::lookup_flags;
 use crate::hb::ot_layout_gpos_table::attach_type;
 use crate::hb::ot_layout_gsubgpos::OT::hb_ot_apply_context_t;
-use crate::hb::ot_layout_gsubgpos::{match_t, skipping_iterator_t, Apply};
+use crate::hb::ot_layout_gsubgpos::{match_t, skipping_iterator_t};
 use skrifa::raw::tables::gpos::{
     AnchorTable, MarkArray, MarkBasePosFormat1, MarkLigPosFormat1, MarkMarkPosFormat1,
 };
@@ -52,14 +53,9 @@ impl MarkArrayExt for MarkArray<'_> {
     }
 }
 
-impl Apply for MarkBasePosFormat1<'_> {
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t) -> Option<()> {
+impl ApplyCovered for MarkBasePosFormat1<'_> {
+    fn apply_covered(&self, ctx: &mut hb_ot_apply_context_t, mark_index: u16) -> Option<()> {
         let buffer = &ctx.buffer;
-        let mark_glyph = ctx.buffer.cur(0).as_glyph();
-        let mark_index = self
-            .mark_coverage()
-            .ok()?
-            .get(skrifa::GlyphId::from(mark_glyph.0))?;
 
         let base_coverage = self.base_coverage().ok()?;
 
@@ -148,14 +144,9 @@ fn accept(buffer: &hb_buffer_t, idx: usize) -> bool {
                 != _hb_glyph_info_get_lig_comp(&buffer.info[idx - 1]) + 1)
 }
 
-impl Apply for MarkMarkPosFormat1<'_> {
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t) -> Option<()> {
+impl ApplyCovered for MarkMarkPosFormat1<'_> {
+    fn apply_covered(&self, ctx: &mut hb_ot_apply_context_t, mark1_index: u16) -> Option<()> {
         let buffer = &ctx.buffer;
-        let mark1_glyph = ctx.buffer.cur(0).as_glyph();
-        let mark1_index = self
-            .mark1_coverage()
-            .ok()?
-            .get(skrifa::GlyphId::from(mark1_glyph.0))?;
 
         // Now we search backwards for a suitable mark glyph until a non-mark glyph
         let mut iter = skipping_iterator_t::new(ctx, buffer.idx, false);
@@ -217,11 +208,9 @@ impl Apply for MarkMarkPosFormat1<'_> {
     }
 }
 
-impl Apply for MarkLigPosFormat1<'_> {
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t) -> Option<()> {
+impl ApplyCovered for MarkLigPosFormat1<'_> {
+    fn apply_covered(&self, ctx: &mut hb_ot_apply_context_t, mark_index: u16) -> Option<()> {
         let buffer = &ctx.buffer;
-        let mark_glyph = ctx.buffer.cur(0).as_skrifa_glyph();
-        let mark_index = self.mark_coverage().ok()?.get(mark_glyph)? as usize;
 
         // Due to borrowing rules, we have this piece of code before creating the
         // iterator, unlike in harfbuzz.
@@ -6,18 +6,19 @@ use crate::hb::{
     ot_layout_gsubgpos::OT::hb_ot_apply_context_t,
 };
 use skrifa::raw::{
-    tables::{
-        gpos::{DeviceOrVariationIndex, Gpos, ValueRecord},
-        variations::DeltaSetIndex,
-    },
+    tables::gpos::{DeviceOrVariationIndex, Gpos, ValueRecord},
     FontData, ReadError, TableProvider,
 };
 
 mod cursive;
 mod mark;
 mod pair;
+mod pair_matrix;
 mod single;
 
+pub use pair::apply_pair_pos2;
+pub use pair_matrix::{PairMatrixCache, DEFAULT_BUDGET as DEFAULT_PAIR_MATRIX_BUDGET};
+
 #[derive(Clone)]
 pub struct GposTable<'a> {
     pub table: Gpos<'a>,
@@ -27,8 +28,7 @@ pub struct GposTable<'a> {
 impl<'a> GposTable<'a> {
     pub fn try_new(font: &impl TableProvider<'a>) -> Option<Self> {
         let table = font.gpos().ok()?;
-        let mut lookups = LookupCache::new();
-        lookups.create_all(&table);
+        let lookups = LookupCache::new(&table);
         Some(Self { table, lookups })
     }
 }
@@ -40,8 +40,8 @@ impl<'a> crate::hb::ot_layout::LayoutTable for GposTable<'a> {
     type Lookup = LookupInfo;
 
     fn get_lookup(&self, index: ttf_parser::opentype_layout::LookupIndex) -> Option<&Self::Lookup> {
-        let lookup = self.lookups.get(index)?;
-        if lookup.subtables_count == 0 {
+        let lookup = self.lookups.get_or_create(&self.table, index)?;
+        if lookup.subtables.is_empty() {
             return None;
         }
         Some(lookup)
@@ -111,18 +111,12 @@ impl ValueRecordExt for Value<'_> {
             }
         }
 
-        if let Some(ivs) = ctx.face.font.ivs.as_ref() {
-            let coords = &ctx.face.font.coords;
+        if ctx.face.font.ivs.is_some() {
+            let font = &ctx.face.font;
             let delta = |val: Result<DeviceOrVariationIndex<'_>, ReadError>| match val {
-                Ok(DeviceOrVariationIndex::VariationIndex(varix)) => ivs
-                    .compute_delta(
-                        DeltaSetIndex {
-                            outer: varix.delta_set_outer_index(),
-                            inner: varix.delta_set_inner_index(),
-                        },
-                        coords,
-                    )
-                    .unwrap_or_default(),
+                Ok(DeviceOrVariationIndex::VariationIndex(varix)) => {
+                    font.delta(varix.delta_set_outer_index(), varix.delta_set_inner_index())
+                }
                 _ => 0,
             };
 
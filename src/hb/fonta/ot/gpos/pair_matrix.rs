@@ -0,0 +1,208 @@
+use super::Value;
+use crate::hb::fonta::once_cell::OnceCell;
+use crate::hb::fonta::ot::cache_budget::CacheBudget;
+use crate::hb::ot_layout_gpos_table::ValueRecordExt;
+use crate::GlyphPosition;
+use alloc::boxed::Box;
+use alloc::vec::Vec;
+use core::sync::atomic::{AtomicU32, Ordering};
+use skrifa::raw::tables::gpos::{PairPosFormat2, ValueRecord};
+use skrifa::raw::FontData;
+
+/// Number of times a subtable is applied before its matrix is decoded.
+const HOT_THRESHOLD: u32 = 64;
+
+/// Memory available for the pair matrices of a single face, in bytes.
+pub const DEFAULT_BUDGET: usize = 1024 * 1024;
+
+const HAS_RECORD2: u8 = 1 << 0;
+const HAS_DEVICE: u8 = 1 << 1;
+const INVALID: u8 = 1 << 2;
+
+/// The static part of a value record.
+#[derive(Clone, Copy, Default)]
+pub struct PairValue {
+    x_placement: i16,
+    y_placement: i16,
+    x_advance: i16,
+    y_advance: i16,
+}
+
+impl PairValue {
+    fn new(record: &ValueRecord) -> Self {
+        Self {
+            x_placement: record.x_placement().unwrap_or_default(),
+            y_placement: record.y_placement().unwrap_or_default(),
+            x_advance: record.x_advance().unwrap_or_default(),
+            y_advance: record.y_advance().unwrap_or_default(),
+        }
+    }
+
+    /// Same as `Value::apply_to_pos`, without device tables.
+    #[inline]
+    pub fn apply_to_pos(&self, pos: &mut GlyphPosition, horizontal: bool) -> bool {
+        let mut worked = false;
+        if self.x_placement != 0 {
+            pos.x_offset += i32::from(self.x_placement);
+            worked = true;
+        }
+        if self.y_placement != 0 {
+            pos.y_offset += i32::from(self.y_placement);
+            worked = true;
+        }
+        if horizontal {
+            if self.x_advance != 0 {
+                pos.x_advance += i32::from(self.x_advance);
+                worked = true;
+            }
+        } else if self.y_advance != 0 {
+            // y_advance values grow downward but font-space grows upward, hence negation
+            pos.y_advance -= i32::from(self.y_advance);
+            worked = true;
+        }
+        worked
+    }
+}
+
+/// The decoded `Class2Record` of a class pair.
+#[derive(Clone, Copy, Default)]
+pub struct PairEntry {
+    pub values: [PairValue; 2],
+    flags: u8,
+}
+
+impl PairEntry {
+    const INVALID: Self = Self {
+        values: [PairValue {
+            x_placement: 0,
+            y_placement: 0,
+            x_advance: 0,
+            y_advance: 0,
+        }; 2],
+        flags: INVALID,
+    };
+
+    fn new(record1: ValueRecord, record2: ValueRecord, data: FontData) -> Self {
+        let has_device = |record: &ValueRecord| {
+            !(record.x_placement_device.get().is_null()
+                && record.y_placement_device.get().is_null()
+                && record.x_advance_device.get().is_null()
+                && record.y_advance_device.get().is_null())
+        };
+        let mut flags = 0;
+        if has_device(&record1) || has_device(&record2) {
+            flags |= HAS_DEVICE;
+        }
+        let values = [PairValue::new(&record1), PairValue::new(&record2)];
+        let value2 = Value {
+            record: record2,
+            data,
+        };
+        if !value2.is_empty() {
+            flags |= HAS_RECORD2;
+        }
+        Self { values, flags }
+    }
+
+    #[inline]
+    pub fn has_record2(&self) -> bool {
+        self.flags & HAS_RECORD2 != 0
+    }
+
+    /// Whether the entry can't be used and the record has to be decoded from the table.
+    ///
+    /// Device tables only apply to variable fonts, since their deltas depend
+    /// on the variation coordinates.
+    #[inline]
+    pub fn needs_decode(&self, has_variations: bool) -> bool {
+        self.flags & INVALID != 0 || (has_variations && self.flags & HAS_DEVICE != 0)
+    }
+}
+
+/// The value records of a `PairPosFormat2` subtable, indexed by class pair.
+pub struct PairMatrix {
+    class2_count: usize,
+    entries: Box<[PairEntry]>,
+}
+
+impl PairMatrix {
+    fn new(subtable: &PairPosFormat2, budget: &CacheBudget) -> Option<Self> {
+        let class1_count = usize::from(subtable.class1_count());
+        let class2_count = usize::from(subtable.class2_count());
+        let len = class1_count.checked_mul(class2_count)?;
+        if len == 0 || !budget.reserve(len * core::mem::size_of::<PairEntry>()) {
+            return None;
+        }
+
+        let data = subtable.offset_data();
+        let records = subtable.class1_records();
+        let mut entries = Vec::with_capacity(len);
+        for class1 in 0..class1_count {
+            let class1_record = records.get(class1);
+            entries.extend((0..class2_count).map(|class2| {
+                match class1_record
+                    .as_ref()
+                    .map(|record| record.class2_records().get(class2))
+                {
+                    Ok(Ok(record)) => {
+                        PairEntry::new(record.value_record1, record.value_record2, data)
+                    }
+                    _ => PairEntry::INVALID,
+                }
+            }));
+        }
+
+        Some(Self {
+            class2_count,
+            entries: entries.into_boxed_slice(),
+        })
+    }
+
+    /// Returns the entry of a class pair, or `None` if a class is out of range.
+    #[inline]
+    pub fn get(&self, class1: u16, class2: u16) -> Option<&PairEntry> {
+        let class2 = usize::from(class2);
+        if class2 >= self.class2_count {
+            return None;
+        }
+        self.entries
+            .get(usize::from(class1) * self.class2_count + class2)
+    }
+}
+
+/// Per-subtable state for the pair matrix of a `PairPosFormat2` subtable.
+#[derive(Default)]
+pub struct PairMatrixCache {
+    queries: AtomicU32,
+    matrix: OnceCell<Option<PairMatrix>>,
+}
+
+impl PairMatrixCache {
+    /// Returns the matrix, decoding it if the subtable turned hot.
+    #[inline]
+    pub fn matrix(&self, subtable: &PairPosFormat2, budget: &CacheBudget) -> Option<&PairMatrix> {
+        if let Some(matrix) = self.matrix.get() {
+            return matrix.as_ref();
+        }
+        if self.queries.fetch_add(1, Ordering::Relaxed) < HOT_THRESHOLD {
+            return None;
+        }
+        self.matrix
+            .get_or_init(|| PairMatrix::new(subtable, budget))
+            .as_ref()
+    }
+}
+
+impl Clone for PairMatrixCache {
+    fn clone(&self) -> Self {
+        Self::default()
+    }
+}
+
+impl core::fmt::Debug for PairMatrixCache {
+    fn fmt(&self, f: &mut core::fmt::Formatter<'_>) -> core::fmt::Result {
+        f.debug_struct("PairMatrixCache")
+            .field("decoded", &self.matrix.get().map_or(false, Option::is_some))
+            .finish()
+    }
+}
@@ -1,13 +1,11 @@
 use super::Value;
+use crate::hb::fonta::ot::ApplyCovered;
 use crate::hb::ot_layout_gpos_table::ValueRecordExt;
-use crate::hb::ot_layout_gsubgpos::Apply;
 use crate::hb::ot_layout_gsubgpos::OT::hb_ot_apply_context_t;
 use skrifa::raw::tables::gpos::{SinglePosFormat1, SinglePosFormat2};
 
-impl Apply for SinglePosFormat1<'_> {
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t) -> Option<()> {
-        let glyph = ctx.buffer.cur(0).as_skrifa_glyph();
-        self.coverage().ok()?.get(glyph)?;
+impl ApplyCovered for SinglePosFormat1<'_> {
+    fn apply_covered(&self, ctx: &mut hb_ot_apply_context_t, _: u16) -> Option<()> {
         let record = self.value_record();
         let value = Value {
             record,
@@ -19,11 +17,9 @@ impl Apply for SinglePosFormat1<'_> {
     }
 }
 
-impl Apply for SinglePosFormat2<'_> {
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t) -> Option<()> {
-        let glyph = ctx.buffer.cur(0).as_skrifa_glyph();
-        let index = self.coverage().ok()?.get(glyph)? as usize;
-        let record = self.value_records().get(index).ok()?;
+impl ApplyCovered for SinglePosFormat2<'_> {
+    fn apply_covered(&self, ctx: &mut hb_ot_apply_context_t, index: u16) -> Option<()> {
+        let record = self.value_records().get(index as usize).ok()?;
         let value = Value {
             record,
             data: self.offset_data(),
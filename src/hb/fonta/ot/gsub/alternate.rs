@@ -1,3 +1,4 @@
+use crate::hb::fonta::ot::ApplyCovered;
 use crate::hb::ot_layout_gsubgpos::OT::hb_ot_apply_context_t;
 use crate::hb::ot_layout_gsubgpos::{Apply, WouldApply, WouldApplyContext};
 use skrifa::raw::tables::gsub::{AlternateSet, AlternateSubstFormat1};
@@ -42,10 +43,8 @@ impl WouldApply for AlternateSubstFormat1<'_> {
     }
 }
 
-impl Apply for AlternateSubstFormat1<'_> {
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t) -> Option<()> {
-        let glyph = ctx.buffer.cur(0).as_glyph();
-        let index = self.coverage().ok()?.get(skrifa::GlyphId::from(glyph.0))?;
+impl ApplyCovered for AlternateSubstFormat1<'_> {
+    fn apply_covered(&self, ctx: &mut hb_ot_apply_context_t, index: u16) -> Option<()> {
         let set = self.alternate_sets().get(index as usize).ok()?;
         set.apply(ctx)
     }
@@ -1,3 +1,4 @@
+use crate::hb::fonta::ot::ApplyCovered;
 use crate::hb::ot_layout_gsubgpos::OT::hb_ot_apply_context_t;
 use crate::hb::ot_layout_gsubgpos::{
     ligate_input, match_glyph, match_input, Apply, WouldApply, WouldApplyContext,
@@ -26,7 +27,7 @@ impl Apply for Ligature<'_> {
             ctx.replace_glyph(GlyphId(self.ligature_glyph().to_u16()));
             Some(())
         } else {
-            let f = |glyph, index| {
+            let f = |glyph: GlyphId, index: u16| {
                 let value = GlyphId(components.get(index as usize).unwrap().get().to_u16());
                 match_glyph(glyph, value.0)
             };
@@ -91,13 +92,11 @@ impl WouldApply for LigatureSubstFormat1<'_> {
     }
 }
 
-impl Apply for LigatureSubstFormat1<'_> {
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t) -> Option<()> {
-        let glyph = ctx.buffer.cur(0).as_glyph();
-        self.coverage()
+impl ApplyCovered for LigatureSubstFormat1<'_> {
+    fn apply_covered(&self, ctx: &mut hb_ot_apply_context_t, index: u16) -> Option<()> {
+        self.ligature_sets()
+            .get(index as usize)
             .ok()
-            .and_then(|coverage| coverage.get(skrifa::GlyphId::from(glyph.0)))
-            .and_then(|index| self.ligature_sets().get(index as usize).ok())
             .and_then(|set| set.apply(ctx))
     }
 }
@@ -19,8 +19,7 @@ pub struct GsubTable<'a> {
 impl<'a> GsubTable<'a> {
     pub fn try_new(font: &impl TableProvider<'a>) -> Option<Self> {
         let table = font.gsub().ok()?;
-        let mut lookups = LookupCache::new();
-        lookups.create_all(&table);
+        let lookups = LookupCache::new(&table);
         Some(Self { table, lookups })
     }
 }
@@ -32,8 +31,8 @@ impl<'a> crate::hb::ot_layout::LayoutTable for GsubTable<'a> {
     type Lookup = LookupInfo;
 
     fn get_lookup(&self, index: ttf_parser::opentype_layout::LookupIndex) -> Option<&Self::Lookup> {
-        let lookup = self.lookups.get(index)?;
-        if lookup.subtables_count == 0 {
+        let lookup = self.lookups.get_or_create(&self.table, index)?;
+        if lookup.subtables.is_empty() {
             return None;
         }
         Some(lookup)
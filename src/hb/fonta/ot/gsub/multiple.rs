@@ -1,10 +1,11 @@
 use crate::hb::buffer::GlyphPropsFlags;
+use crate::hb::fonta::ot::ApplyCovered;
 use crate::hb::ot_layout::{
     _hb_glyph_info_get_lig_id, _hb_glyph_info_is_ligature,
     _hb_glyph_info_set_lig_props_for_component,
 };
 use crate::hb::ot_layout_gsubgpos::OT::hb_ot_apply_context_t;
-use crate::hb::ot_layout_gsubgpos::{Apply, WouldApply, WouldApplyContext};
+use crate::hb::ot_layout_gsubgpos::{WouldApply, WouldApplyContext};
 use skrifa::raw::tables::gsub::MultipleSubstFormat1;
 use ttf_parser::GlyphId;
 
@@ -18,11 +19,13 @@ impl WouldApply for MultipleSubstFormat1<'_> {
     }
 }
 
-impl Apply for MultipleSubstFormat1<'_> {
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t) -> Option<()> {
-        let gid = ctx.buffer.cur(0).as_skrifa_glyph16();
-        let index = self.coverage().ok()?.get(gid)? as usize;
-        let substs = self.sequences().get(index).ok()?.substitute_glyph_ids();
+impl ApplyCovered for MultipleSubstFormat1<'_> {
+    fn apply_covered(&self, ctx: &mut hb_ot_apply_context_t, index: u16) -> Option<()> {
+        let substs = self
+            .sequences()
+            .get(index as usize)
+            .ok()?
+            .substitute_glyph_ids();
         match substs.len() {
             // Spec disallows this, but Uniscribe allows it.
             // https://github.com/harfbuzz/harfbuzz/issues/253
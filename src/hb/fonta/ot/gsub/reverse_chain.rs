@@ -1,7 +1,8 @@
+use crate::hb::fonta::ot::ApplyCovered;
 use crate::hb::ot_layout::MAX_NESTING_LEVEL;
 use crate::hb::ot_layout_gsubgpos::OT::hb_ot_apply_context_t;
 use crate::hb::ot_layout_gsubgpos::{
-    match_backtrack, match_lookahead, Apply, WouldApply, WouldApplyContext,
+    match_backtrack, match_lookahead, WouldApply, WouldApplyContext,
 };
 use skrifa::raw::tables::gsub::ReverseChainSingleSubstFormat1;
 use ttf_parser::GlyphId;
@@ -17,16 +18,14 @@ impl WouldApply for ReverseChainSingleSubstFormat1<'_> {
     }
 }
 
-impl Apply for ReverseChainSingleSubstFormat1<'_> {
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t) -> Option<()> {
+impl ApplyCovered for ReverseChainSingleSubstFormat1<'_> {
+    fn apply_covered(&self, ctx: &mut hb_ot_apply_context_t, coverage_index: u16) -> Option<()> {
         // No chaining to this type.
         if ctx.nesting_level_left != MAX_NESTING_LEVEL {
             return None;
         }
 
-        let glyph = skrifa::GlyphId::from(ctx.buffer.cur(0).as_glyph().0);
-        let coverage = self.coverage().ok()?;
-        let index = coverage.get(glyph)? as usize;
+        let index = coverage_index as usize;
         let substitutes = self.substitute_glyph_ids();
         if index >= substitutes.len() {
             return None;
@@ -37,12 +36,12 @@ impl Apply for ReverseChainSingleSubstFormat1<'_> {
         let backtrack_coverages = self.backtrack_coverages();
         let lookahead_coverages = self.lookahead_coverages();
 
-        let f1 = |glyph: GlyphId, index| {
+        let f1 = |glyph: GlyphId, index: u16| {
             let value = backtrack_coverages.get(index as usize).unwrap();
             value.get(skrifa::GlyphId::from(glyph.0)).is_some()
         };
 
-        let f2 = |glyph: GlyphId, index| {
+        let f2 = |glyph: GlyphId, index: u16| {
             let value = lookahead_coverages.get(index as usize).unwrap();
             value.get(skrifa::GlyphId::from(glyph.0)).is_some()
         };
@@ -1,5 +1,6 @@
+use crate::hb::fonta::ot::ApplyCovered;
 use crate::hb::ot_layout_gsubgpos::OT::hb_ot_apply_context_t;
-use crate::hb::ot_layout_gsubgpos::{Apply, WouldApply, WouldApplyContext};
+use crate::hb::ot_layout_gsubgpos::{WouldApply, WouldApplyContext};
 use skrifa::raw::tables::gsub::{SingleSubstFormat1, SingleSubstFormat2};
 use ttf_parser::GlyphId;
 
@@ -14,10 +15,9 @@ impl WouldApply for SingleSubstFormat1<'_> {
     }
 }
 
-impl Apply for SingleSubstFormat1<'_> {
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t) -> Option<()> {
+impl ApplyCovered for SingleSubstFormat1<'_> {
+    fn apply_covered(&self, ctx: &mut hb_ot_apply_context_t, _: u16) -> Option<()> {
         let glyph = ctx.buffer.cur(0).as_skrifa_glyph16();
-        self.coverage().ok()?.get(glyph)?;
         let subst = (glyph.to_u16() as i32 + self.delta_glyph_id() as i32) as u16;
         ctx.replace_glyph(GlyphId(subst));
         Some(())
@@ -34,11 +34,13 @@ impl WouldApply for SingleSubstFormat2<'_> {
     }
 }
 
-impl Apply for SingleSubstFormat2<'_> {
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t) -> Option<()> {
-        let glyph = ctx.buffer.cur(0).as_skrifa_glyph();
-        let index = self.coverage().ok()?.get(glyph)? as usize;
-        let subst = self.substitute_glyph_ids().get(index)?.get().to_u16();
+impl ApplyCovered for SingleSubstFormat2<'_> {
+    fn apply_covered(&self, ctx: &mut hb_ot_apply_context_t, index: u16) -> Option<()> {
+        let subst = self
+            .substitute_glyph_ids()
+            .get(index as usize)?
+            .get()
+            .to_u16();
         ctx.replace_glyph(GlyphId(subst));
         Some(())
     }
@@ -1,7 +1,10 @@
+use super::cache_budget::CacheBudget;
+use super::coverage_cache::CoverageCache;
+use super::gpos::PairMatrixCache;
+use crate::hb::fonta::once_cell::OnceCell;
 use crate::hb::set_digest::{hb_set_digest_ext, hb_set_digest_t};
 
 use alloc::vec::Vec;
-use core::ops::Range;
 use skrifa::raw::{
     tables::{
         gpos::{
@@ -87,55 +90,39 @@ pub struct LookupData<'a> {
 
 /// Cache containing lookup and subtable information for a single GSUB or
 /// GPOS table.
+///
+/// Entries are populated lazily the first time a lookup is requested, so
+/// creating the cache only costs an allocation proportional to the number of
+/// lookups.
 #[derive(Clone, Default)]
 pub struct LookupCache {
-    pub lookups: Vec<LookupInfo>,
-    pub subtables: Vec<SubtableInfo>,
+    lookups: Vec<OnceCell<Option<LookupInfo>>>,
 }
 
 impl LookupCache {
-    pub fn new() -> Self {
-        Self::default()
-    }
-
-    pub fn clear(&mut self) {
-        self.lookups.clear();
-        self.subtables.clear();
-    }
-
-    pub fn create_all<'a>(&mut self, host: &impl LookupHost<'a>) {
-        self.clear();
-        let count = host.lookup_count();
-        self.lookups.resize(count as usize, Default::default());
-        for i in 0..count {
-            let _ = self.get_or_create(host, i);
-        }
+    pub fn new<'a>(host: &impl LookupHost<'a>) -> Self {
+        let count = host.lookup_count() as usize;
+        let mut lookups = Vec::with_capacity(count);
+        lookups.resize_with(count, OnceCell::new);
+        Self { lookups }
     }
 
-    pub fn get(&self, index: u16) -> Option<&LookupInfo> {
-        let entry = self.lookups.get(index as usize)?;
-        match entry.state {
-            LookupState::Ready => Some(&entry),
-            _ => None,
-        }
+    /// Returns the lookup at `index`, parsing it on first access.
+    pub fn get_or_create<'a>(&self, host: &impl LookupHost<'a>, index: u16) -> Option<&LookupInfo> {
+        self.lookups
+            .get(index as usize)?
+            .get_or_init(|| LookupInfo::new(host, index).ok())
+            .as_ref()
     }
+}
 
-    pub fn get_or_create<'a>(
-        &mut self,
-        cx: &impl LookupHost<'a>,
-        index: u16,
-    ) -> Result<&LookupInfo, ReadError> {
-        let index = index as usize;
-        if index >= self.lookups.len() {
-            self.lookups.resize(index + 1, LookupInfo::default());
-        }
-        let entry = &mut self.lookups[index];
-        if entry.state != LookupState::Vacant {
-            return Ok(entry);
-        }
-        entry.state = LookupState::Error;
-        let data = cx.lookup_data(index as u16)?;
-        entry.is_subst = data.is_subst;
+impl LookupInfo {
+    fn new<'a>(host: &impl LookupHost<'a>, index: u16) -> Result<Self, ReadError> {
+        let data = host.lookup_data(index)?;
+        let mut entry = LookupInfo {
+            is_subst: data.is_subst,
+            ..LookupInfo::default()
+        };
         let lookup_data = data
             .table_data
             .split_off(data.offset)
@@ -152,12 +139,6 @@ impl LookupCache {
             entry.is_reversed =
                 is_reversed(data.table_data, &lookup, data.offset).unwrap_or_default();
         }
-        entry.subtables_start = self
-            .subtables
-            .len()
-            .try_into()
-            .map_err(|_| ReadError::MalformedData("too many subtables"))?;
-        entry.state = LookupState::Ready;
         let mut process_subtable = |mut subtable_offset: usize| {
             let mut subtable_kind = kind;
             match (data.is_subst, kind) {
@@ -181,6 +162,8 @@ impl LookupCache {
                 is_subst: data.is_subst,
                 lookup_type: subtable_kind as u8,
                 digest: Default::default(),
+                coverage_cache: Default::default(),
+                pair_matrix: Default::default(),
             };
             // TODO: update as we add more subtables
             let is_supported = match (data.is_subst, subtable_kind) {
@@ -212,8 +195,7 @@ impl LookupCache {
             // subtable_info.digest.insert_coverage(&coverage);
             // entry.digest.insert_coverage(&coverage);
             subtable_info.coverage_offset = coverage_offset;
-            self.subtables.push(subtable_info);
-            entry.subtables_count += 1;
+            entry.subtables.push(subtable_info);
             Ok::<(), ReadError>(())
         };
         for subtable_offset in lookup.subtable_offsets() {
@@ -223,10 +205,6 @@ impl LookupCache {
         }
         Ok(entry)
     }
-
-    pub fn subtables(&self, entry: &LookupInfo) -> Option<&[SubtableInfo]> {
-        self.subtables.get(entry.subtables_range())
-    }
 }
 
 fn is_reversed(table_data: FontData, lookup: &Lookup<()>, lookup_offset: usize) -> Option<bool> {
@@ -262,47 +240,22 @@ fn add_coverage_to_digest(coverage: &CoverageTable, digest: &mut hb_set_digest_t
     }
 }
 
-/// Current state of a lookup cache entry.
-#[derive(Copy, Clone, PartialEq, Eq, Default, Debug)]
-#[repr(u8)]
-pub enum LookupState {
-    /// Lookup has not been cached yet. This supports
-    /// lazy population of the lookup cache.
-    #[default]
-    Vacant,
-    /// Lookup is available for use.
-    Ready,
-    /// An error occured while reading this lookup.
-    Error,
-}
-
 /// Cached information about a lookup.
 #[derive(Clone, Default, Debug)]
 pub struct LookupInfo {
-    /// Current state of this lookup info entry.
-    pub state: LookupState,
     pub props: u32,
     pub is_subst: bool,
     /// Indicates RTL processing for cursive lookups.
     pub is_rtl: bool,
     /// True if glyphs should be processed in reverse for this lookup.
     pub is_reversed: bool,
-    /// Index of the first subtable in the cache subtables vector.
-    pub subtables_start: u32,
-    /// Number of subtables in the cache subtables vector.
-    pub subtables_count: u16,
+    /// Supported subtables of this lookup.
+    pub subtables: Vec<SubtableInfo>,
     /// Bloom filter representing the set of glyphs from the primary
     /// coverage of all subtables in the lookup.
     pub digest: hb_set_digest_t,
 }
 
-impl LookupInfo {
-    pub fn subtables_range(&self) -> Range<usize> {
-        let start = self.subtables_start as usize;
-        start..start + self.subtables_count as usize
-    }
-}
-
 /// Cached information about a subtable.
 #[derive(Clone, Debug)]
 pub struct SubtableInfo {
@@ -318,6 +271,10 @@ pub struct SubtableInfo {
     /// Original lookup type.
     pub lookup_type: u8,
     pub digest: hb_set_digest_t,
+    /// Accelerator for `primary_coverage`, built once the subtable is hot.
+    pub coverage_cache: CoverageCache,
+    /// Decoded value records of a `PairPosFormat2` subtable.
+    pub pair_matrix: PairMatrixCache,
 }
 
 impl SubtableInfo {
@@ -330,9 +287,17 @@ impl SubtableInfo {
         CoverageTable::read(data)
     }
 
-    pub fn primary_coverage(&self, table_data: &[u8], glyph_id: GlyphId) -> Option<u16> {
-        let coverage = self.primary_coverage_table(table_data).ok()?;
-        coverage.get(glyph_id)
+    pub fn primary_coverage(
+        &self,
+        table_data: &[u8],
+        glyph_id: GlyphId,
+        budget: &CacheBudget,
+    ) -> Option<u16> {
+        let coverage = || self.primary_coverage_table(table_data).ok();
+        if let Some(accelerator) = self.coverage_cache.accelerator(coverage, budget) {
+            return accelerator.get(glyph_id.to_u32());
+        }
+        coverage()?.get(glyph_id)
     }
 
     pub fn materialize<'a>(&self, table_data: &'a [u8]) -> Result<Subtable<'a>, ReadError> {
@@ -1,14 +1,20 @@
+use super::once_cell::OnceCell;
 use crate::hb::{
     ot_layout::LayoutLookup,
     ot_layout_gsubgpos::{Apply, OT::hb_ot_apply_context_t},
     set_digest::hb_set_digest_ext,
 };
+use alloc::boxed::Box;
+use alloc::vec::Vec;
+use cache_budget::CacheBudget;
 use skrifa::raw::{
-    tables::{gdef::Gdef, variations::ItemVariationStore},
+    tables::{gdef::Gdef, layout::CoverageTable, variations::ItemVariationStore},
     TableProvider,
 };
 
+pub(crate) mod cache_budget;
 mod contextual;
+mod coverage_cache;
 mod gpos;
 mod gsub;
 mod lookup_cache;
@@ -22,6 +28,12 @@ pub struct LayoutTables<'a> {
     pub gsub: Option<GsubTable<'a>>,
     pub gpos: Option<GposTable<'a>>,
     pub gdef: Option<Gdef<'a>>,
+    /// Memory budget for the coverage accelerators of both GSUB and GPOS.
+    pub coverage_budget: CacheBudget,
+    /// Memory budget for the GPOS pair matrices.
+    pub pair_matrix_budget: CacheBudget,
+    /// GDEF mark glyph sets as bitsets indexed by glyph id, built on first use.
+    mark_glyph_sets: OnceCell<Box<[OnceCell<Box<[u64]>>]>>,
 }
 
 impl<'a> LayoutTables<'a> {
@@ -30,9 +42,37 @@ impl<'a> LayoutTables<'a> {
             gsub: GsubTable::try_new(font),
             gpos: GposTable::try_new(font),
             gdef: font.gdef().ok(),
+            coverage_budget: CacheBudget::new(coverage_cache::DEFAULT_BUDGET),
+            pair_matrix_budget: CacheBudget::new(gpos::DEFAULT_PAIR_MATRIX_BUDGET),
+            mark_glyph_sets: OnceCell::new(),
         }
     }
 
+    /// Checks that `glyph` is in the GDEF mark glyph set `set_index`.
+    pub fn is_mark_glyph(&self, glyph: u32, set_index: u16) -> bool {
+        let sets = self.mark_glyph_sets.get_or_init(|| {
+            let count = self
+                .gdef
+                .as_ref()
+                .and_then(|gdef| gdef.mark_glyph_sets_def()?.ok())
+                .map_or(0, |sets| sets.mark_glyph_set_count());
+            (0..count).map(|_| OnceCell::new()).collect()
+        });
+        let Some(set) = sets.get(usize::from(set_index)) else {
+            return false;
+        };
+        let bits = set.get_or_init(|| {
+            self.gdef
+                .as_ref()
+                .and_then(|gdef| gdef.mark_glyph_sets_def()?.ok())
+                .and_then(|sets| sets.coverages().get(usize::from(set_index)).ok())
+                .map(|coverage| coverage_to_bits(&coverage))
+                .unwrap_or_default()
+        });
+        bits.get(glyph as usize / 64)
+            .map_or(false, |word| word & (1 << (glyph % 64)) != 0)
+    }
+
     pub fn item_variation_store(&self) -> Option<ItemVariationStore<'a>> {
         self.gdef
             .as_ref()
@@ -40,6 +80,32 @@ impl<'a> LayoutTables<'a> {
     }
 }
 
+fn coverage_to_bits(coverage: &CoverageTable) -> Box<[u64]> {
+    let mut bits = Vec::new();
+    let mut insert = |glyph: u32| {
+        let word = glyph as usize / 64;
+        if word >= bits.len() {
+            bits.resize(word + 1, 0u64);
+        }
+        bits[word] |= 1 << (glyph % 64);
+    };
+    match coverage {
+        CoverageTable::Format1(table) => {
+            for glyph in table.glyph_array() {
+                insert(glyph.get().to_u32());
+            }
+        }
+        CoverageTable::Format2(table) => {
+            for range in table.range_records() {
+                for glyph in range.start_glyph_id().to_u32()..=range.end_glyph_id().to_u32() {
+                    insert(glyph);
+                }
+            }
+        }
+    }
+    bits.into_boxed_slice()
+}
+
 impl LayoutLookup for LookupInfo {
     fn props(&self) -> u32 {
         self.props
@@ -54,51 +120,67 @@ impl LayoutLookup for LookupInfo {
     }
 }
 
+/// Like `Apply`, for subtables whose primary coverage the caller has already
+/// checked. `coverage_index` is the index of the current glyph in it.
+pub trait ApplyCovered {
+    fn apply_covered(&self, ctx: &mut hb_ot_apply_context_t, coverage_index: u16) -> Option<()>;
+}
+
 impl Apply for LookupInfo {
     fn apply(&self, ctx: &mut hb_ot_apply_context_t) -> Option<()> {
         let glyph = ctx.buffer.cur(0).as_glyph();
         if !self.digest.may_have_glyph(glyph) {
             return None;
         }
-        let (table_data, lookups) = if self.is_subst {
-            let table = ctx.face.font.ot.gsub.as_ref()?;
-            (table.table.offset_data().as_bytes(), &table.lookups)
+        let ot = &ctx.face.font.tables.ot;
+        let table_data = if self.is_subst {
+            let table = ot.gsub.as_ref()?;
+            table.table.offset_data().as_bytes()
         } else {
-            let table = ctx.face.font.ot.gpos.as_ref()?;
-            (table.table.offset_data().as_bytes(), &table.lookups)
+            let table = ot.gpos.as_ref()?;
+            table.table.offset_data().as_bytes()
         };
-        let subtables = lookups.subtables(self)?;
-        for subtable_info in subtables {
+        for subtable_info in &self.subtables {
             if !subtable_info.digest.may_have_glyph(glyph) {
                 continue;
             }
-            // if subtable_info
-            //     .primary_coverage(table_data, skrifa::GlyphId::from(glyph.0))
-            //     .is_none()
-            // {
-            //     continue;
-            // }
+            let Some(index) = subtable_info.primary_coverage(
+                table_data,
+                skrifa::GlyphId::from(glyph.0),
+                &ot.coverage_budget,
+            ) else {
+                continue;
+            };
             let Ok(subtable) = subtable_info.materialize(table_data) else {
                 continue;
             };
             let result = match subtable {
-                Subtable::SingleSubst1(subtable) => subtable.apply(ctx),
-                Subtable::SingleSubst2(subtable) => subtable.apply(ctx),
-                Subtable::MultipleSubst1(subtable) => subtable.apply(ctx),
-                Subtable::AlternateSubst1(subtable) => subtable.apply(ctx),
-                Subtable::LigatureSubst1(subtable) => subtable.apply(ctx),
-                Subtable::ReverseChainContext(subtable) => subtable.apply(ctx),
-                Subtable::SinglePos1(subtable) => subtable.apply(ctx),
-                Subtable::SinglePos2(subtable) => subtable.apply(ctx),
-                Subtable::PairPos1(subtable) => subtable.apply(ctx),
-                Subtable::PairPos2(subtable) => subtable.apply(ctx),
-                Subtable::CursivePos1(subtable) => subtable.apply(ctx),
-                Subtable::MarkBasePos1(subtable) => subtable.apply(ctx),
-                Subtable::MarkLigPos1(subtable) => subtable.apply(ctx),
-                Subtable::MarkMarkPos1(subtable) => subtable.apply(ctx),
-                Subtable::ChainedContextFormat1(subtable) => subtable.apply(ctx),
-                Subtable::ChainedContextFormat2(subtable) => subtable.apply(ctx),
-                Subtable::ChainedContextFormat3(subtable) => subtable.apply(ctx),
+                Subtable::SingleSubst1(subtable) => subtable.apply_covered(ctx, index),
+                Subtable::SingleSubst2(subtable) => subtable.apply_covered(ctx, index),
+                Subtable::MultipleSubst1(subtable) => subtable.apply_covered(ctx, index),
+                Subtable::AlternateSubst1(subtable) => subtable.apply_covered(ctx, index),
+                Subtable::LigatureSubst1(subtable) => subtable.apply_covered(ctx, index),
+                Subtable::ReverseChainContext(subtable) => subtable.apply_covered(ctx, index),
+                Subtable::SinglePos1(subtable) => subtable.apply_covered(ctx, index),
+                Subtable::SinglePos2(subtable) => subtable.apply_covered(ctx, index),
+                Subtable::PairPos1(subtable) => subtable.apply_covered(ctx, index),
+                Subtable::PairPos2(subtable) => {
+                    let matrix = if ctx.face.pair_pos_cache {
+                        subtable_info
+                            .pair_matrix
+                            .matrix(&subtable, &ot.pair_matrix_budget)
+                    } else {
+                        None
+                    };
+                    gpos::apply_pair_pos2(&subtable, ctx, matrix)
+                }
+                Subtable::CursivePos1(subtable) => subtable.apply_covered(ctx, index),
+                Subtable::MarkBasePos1(subtable) => subtable.apply_covered(ctx, index),
+                Subtable::MarkLigPos1(subtable) => subtable.apply_covered(ctx, index),
+                Subtable::MarkMarkPos1(subtable) => subtable.apply_covered(ctx, index),
+                Subtable::ChainedContextFormat1(subtable) => subtable.apply_covered(ctx, index),
+                Subtable::ChainedContextFormat2(subtable) => subtable.apply_covered(ctx, index),
+                Subtable::ChainedContextFormat3(subtable) => subtable.apply_covered(ctx, index),
                 _ => None,
             };
             if result.is_some() {
@@ -1,6 +1,10 @@
+use alloc::boxed::Box;
+use alloc::vec::Vec;
 use ttf_parser::{apple_layout, kern, GlyphId};
 
+use super::aat_layout_common::hb_aat_class_table_t;
 use super::buffer::*;
+use super::fonta::once_cell::OnceCell;
 use super::ot_layout::TableIndex;
 use super::ot_layout_common::lookup_flags;
 use super::ot_layout_gpos_table::attach_type;
@@ -15,7 +19,7 @@ pub fn hb_ot_layout_kern(plan: &hb_ot_shape_plan_t, face: &hb_font_t, buffer: &m
     };
 
     let mut seen_cross_stream = false;
-    for subtable in subtables {
+    for (index, subtable) in subtables.into_iter().enumerate() {
         if subtable.variable {
             continue;
         }
@@ -44,13 +48,13 @@ pub fn hb_ot_layout_kern(plan: &hb_ot_shape_plan_t, face: &hb_font_t, buffer: &m
         }
 
         if subtable.has_state_machine {
-            apply_state_machine_kerning(&subtable, plan.kern_mask, buffer);
+            apply_state_machine_kerning(&subtable, index, face, plan.kern_mask, buffer);
         } else {
             if !plan.requested_kerning {
                 continue;
             }
 
-            apply_simple_kerning(&subtable, face, plan.kern_mask, buffer);
+            apply_simple_kerning(&subtable, index, face, plan.kern_mask, buffer);
         }
 
         if reverse {
@@ -127,22 +131,108 @@ fn machine_kern(
     }
 }
 
+/// The pairs of a `kern` format 0 subtable, decoded and grouped by left glyph.
+pub(crate) struct hb_kern_pair_index_t {
+    // The pairs of left glyph `i` are `rows[i]..rows[i + 1]`.
+    rows: Box<[u32]>,
+    rights: Box<[u16]>,
+    values: Box<[i16]>,
+}
+
+impl hb_kern_pair_index_t {
+    fn new(pairs: impl Iterator<Item = (u32, i16)>) -> Self {
+        let mut pairs: Vec<_> = pairs.collect();
+        // Pairs are sorted in valid fonts, but the lookup relies on it.
+        pairs.sort_by_key(|&(pair, _)| pair);
+        pairs.dedup_by_key(|&mut (pair, _)| pair);
+
+        let row_count = pairs
+            .last()
+            .map_or(0, |&(pair, _)| (pair >> 16) as usize + 1);
+        let mut rows = Vec::with_capacity(row_count + 1);
+        rows.push(0);
+        let mut start = 0;
+        for left in 0..row_count as u32 {
+            start += pairs[start..]
+                .iter()
+                .take_while(|&&(pair, _)| pair >> 16 == left)
+                .count();
+            rows.push(start as u32);
+        }
+
+        hb_kern_pair_index_t {
+            rows: rows.into_boxed_slice(),
+            rights: pairs.iter().map(|&(pair, _)| pair as u16).collect(),
+            values: pairs.iter().map(|&(_, value)| value).collect(),
+        }
+    }
+
+    #[inline]
+    fn get(&self, left: u32, right: u32) -> Option<i16> {
+        let left = left as usize;
+        if left + 1 >= self.rows.len() {
+            return None;
+        }
+
+        let start = self.rows[left] as usize;
+        let end = self.rows[left + 1] as usize;
+        let index = self.rights[start..end]
+            .binary_search(&u16::try_from(right).ok()?)
+            .ok()?;
+        Some(self.values[start + index])
+    }
+}
+
+/// Pair indices of the format 0 subtables of a face's `kern` table, built on first use.
+#[derive(Default)]
+pub(crate) struct hb_kern_pair_cache_t {
+    subtables: OnceCell<Box<[OnceCell<Option<hb_kern_pair_index_t>>]>>,
+}
+
+impl hb_kern_pair_cache_t {
+    fn get(&self, face: &hb_font_t, index: usize) -> Option<&hb_kern_pair_index_t> {
+        let subtables = self.subtables.get_or_init(|| {
+            let count = face
+                .tables()
+                .kern
+                .map_or(0, |kern| kern.subtables.into_iter().count());
+            (0..count).map(|_| OnceCell::new()).collect()
+        });
+        subtables
+            .get(index)?
+            .get_or_init(|| {
+                let subtable = face.tables().kern?.subtables.into_iter().nth(index)?;
+                match subtable.format {
+                    kern::Format::Format0(ref table) => Some(hb_kern_pair_index_t::new(
+                        table.pairs.into_iter().map(|pair| (pair.pair, pair.value)),
+                    )),
+                    _ => None,
+                }
+            })
+            .as_ref()
+    }
+}
+
 fn apply_simple_kerning(
     subtable: &kern::Subtable,
+    subtable_index: usize,
     face: &hb_font_t,
     kern_mask: hb_mask_t,
     buffer: &mut hb_buffer_t,
 ) {
+    let pairs = face.face_data.kern_pairs.get(face, subtable_index);
     machine_kern(
         face,
         buffer,
         kern_mask,
         subtable.has_cross_stream,
         |left, right| {
-            subtable
-                .glyphs_kerning(GlyphId(left as u16), GlyphId(right as u16))
-                .map(i32::from)
-                .unwrap_or(0)
+            match pairs {
+                Some(pairs) => pairs.get(left, right),
+                None => subtable.glyphs_kerning(GlyphId(left as u16), GlyphId(right as u16)),
+            }
+            .map(i32::from)
+            .unwrap_or(0)
         },
     );
 }
@@ -154,6 +244,8 @@ struct StateMachineDriver {
 
 fn apply_state_machine_kerning(
     subtable: &kern::Subtable,
+    subtable_index: usize,
+    face: &hb_font_t,
     kern_mask: hb_mask_t,
     buffer: &mut hb_buffer_t,
 ) {
@@ -162,6 +254,17 @@ fn apply_state_machine_kerning(
         _ => return,
     };
 
+    let classes = face.face_data.aat_classes.classes(
+        hb_aat_class_table_t::Kern,
+        || {
+            face.tables()
+                .kern
+                .map_or(0, |kern| kern.subtables.into_iter().count())
+        },
+        subtable_index,
+        face.number_of_glyphs(),
+    );
+
     let mut driver = StateMachineDriver {
         stack: [0; 8],
         depth: 0,
@@ -171,9 +274,12 @@ fn apply_state_machine_kerning(
     buffer.idx = 0;
     loop {
         let class = if buffer.idx < buffer.len {
-            state_table
-                .class(buffer.info[buffer.idx].as_glyph())
-                .unwrap_or(1)
+            let glyph = buffer.info[buffer.idx].as_glyph();
+            let class = || state_table.class(glyph).unwrap_or(1);
+            match classes {
+                Some(classes) => classes.get(glyph, || u16::from(class())) as u8,
+                None => class(),
+            }
         } else {
             apple_layout::class::END_OF_TEXT as u8
         };
@@ -328,3 +434,33 @@ fn state_machine_transition(
         }
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::hb_kern_pair_index_t;
+
+    #[test]
+    fn pair_index() {
+        let pair = |left: u32, right: u32, value| (left << 16 | right, value);
+        let index = hb_kern_pair_index_t::new(
+            [
+                pair(1, 5, -10),
+                pair(1, 7, -20),
+                pair(4, 1, 30),
+                pair(4, 0xFFFF, 40),
+                pair(2, 3, 50),
+            ]
+            .into_iter(),
+        );
+
+        assert_eq!(index.get(1, 5), Some(-10));
+        assert_eq!(index.get(1, 7), Some(-20));
+        assert_eq!(index.get(2, 3), Some(50));
+        assert_eq!(index.get(4, 1), Some(30));
+        assert_eq!(index.get(4, 0xFFFF), Some(40));
+        assert_eq!(index.get(1, 6), None);
+        assert_eq!(index.get(3, 3), None);
+        assert_eq!(index.get(5, 1), None);
+        assert_eq!(index.get(0, 0), None);
+    }
+}
@@ -51,13 +51,19 @@ mod ot_shaper_vowel_constraints;
 mod paint_extents;
 mod set_digest;
 pub mod shape;
+#[cfg(feature = "parallel")]
+mod shape_parallel;
+mod shape_stream;
 #[cfg(feature = "wasm-shaper")]
 mod shape_wasm;
+pub mod stats;
 mod tag;
 mod tag_table;
 mod text_parser;
 mod unicode;
 mod unicode_norm;
+mod unicode_props;
+pub mod word_cache;
 
 use ttf_parser::Tag as hb_tag_t;
 
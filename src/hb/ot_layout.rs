@@ -9,6 +9,7 @@ use super::ot_shape_plan::hb_ot_shape_plan_t;
 use super::unicode::{hb_unicode_funcs_t, hb_unicode_general_category_t, GeneralCategoryExt};
 use super::{hb_font_t, hb_glyph_info_t, hb_tag_t};
 use crate::hb::set_digest::{hb_set_digest_ext, hb_set_digest_t};
+use crate::hb::stats::hb_lookup_counters_t;
 use ttf_parser::opentype_layout::{FeatureIndex, LanguageIndex, LookupIndex, ScriptIndex};
 
 pub const MAX_NESTING_LEVEL: usize = 64;
@@ -38,8 +39,21 @@ pub fn hb_ot_layout_has_cross_kerning(face: &hb_font_t) -> bool {
 
 pub fn _hb_ot_layout_set_glyph_props(face: &hb_font_t, buffer: &mut hb_buffer_t) {
     let len = buffer.len;
+    let props = face.glyph_props_table();
+    if props.is_empty() {
+        for info in &mut buffer.info[..len] {
+            info.set_glyph_props(0);
+            info.set_lig_props(0);
+        }
+        return;
+    }
+
     for info in &mut buffer.info[..len] {
-        info.set_glyph_props(face.glyph_props(info.as_glyph()));
+        let glyph_props = match props.get(info.glyph_id as usize) {
+            Some(glyph_props) => *glyph_props,
+            None => face.glyph_props(info.as_glyph()),
+        };
+        info.set_glyph_props(glyph_props);
         info.set_lig_props(0);
     }
 }
@@ -258,8 +272,8 @@ pub fn apply_layout_table<T: LayoutTable>(
             }
         }
 
-        if let Some(func) = stage.pause_func {
-            if func(plan, face, ctx.buffer) {
+        if let Some(pause) = stage.pause {
+            if pause.apply(plan, face, ctx.buffer) {
                 ctx.digest = ctx.buffer.digest();
             }
         }
@@ -277,30 +291,40 @@ pub fn apply_layout_table2<T: LayoutTable, T2: LayoutTable>(
     let mut ctx = OT::hb_ot_apply_context_t::new(T::INDEX, face, buffer);
 
     for (stage_index, stage) in plan.ot_map.stages(T::INDEX).iter().enumerate() {
-        for lookup in plan.ot_map.stage_lookups(T::INDEX, stage_index) {
-            ctx.lookup_index = lookup.index;
-            ctx.set_lookup_mask(lookup.mask);
-            ctx.auto_zwj = lookup.auto_zwj;
-            ctx.auto_zwnj = lookup.auto_zwnj;
-
-            ctx.random = lookup.random;
-            ctx.per_syllable = lookup.per_syllable;
-
-            if let Some(table) = &table2 {
-                if let Some(lookup) = table.get_lookup(lookup.index) {
-                    apply_string::<T2>(&mut ctx, lookup);
-                    continue;
-                }
+        for lookup_map in plan.ot_map.stage_lookups(T::INDEX, stage_index) {
+            let lookup2 = table2.and_then(|table| table.get_lookup(lookup_map.index));
+            let lookup = match lookup2 {
+                Some(_) => None,
+                None => table.and_then(|table| table.get_lookup(lookup_map.index)),
+            };
+            let digest = match (lookup2, lookup) {
+                (Some(lookup), _) => lookup.digest(),
+                (None, Some(lookup)) => lookup.digest(),
+                (None, None) => continue,
+            };
+            if !digest.may_have(&ctx.digest) {
+                continue;
             }
-            if let Some(table) = &table {
-                if let Some(lookup) = table.get_lookup(lookup.index) {
-                    apply_string::<T>(&mut ctx, lookup);
-                }
+
+            ctx.lookup_index = lookup_map.index;
+            ctx.set_lookup_mask(lookup_map.mask);
+            ctx.auto_zwj = lookup_map.auto_zwj;
+            ctx.auto_zwnj = lookup_map.auto_zwnj;
+
+            ctx.random = lookup_map.random;
+            ctx.per_syllable = lookup_map.per_syllable;
+
+            if let Some(lookup) = lookup2 {
+                apply_string::<T2>(&mut ctx, lookup);
+            } else if let Some(lookup) = lookup {
+                apply_string::<T>(&mut ctx, lookup);
             }
         }
 
-        if let Some(func) = stage.pause_func {
-            func(plan, face, ctx.buffer);
+        if let Some(pause) = stage.pause {
+            if pause.apply(plan, face, ctx.buffer) {
+                ctx.digest = ctx.buffer.digest();
+            }
         }
     }
 }
@@ -310,6 +334,9 @@ fn apply_string<T: LayoutTable>(ctx: &mut OT::hb_ot_apply_context_t, lookup: &T:
         return;
     }
 
+    let mut counters = hb_lookup_counters_t::default();
+    let digest_glyphs = ctx.buffer.len;
+
     ctx.lookup_props = lookup.props();
 
     if !lookup.is_reverse() {
@@ -318,7 +345,7 @@ fn apply_string<T: LayoutTable>(ctx: &mut OT::hb_ot_apply_context_t, lookup: &T:
             ctx.buffer.clear_output();
         }
         ctx.buffer.idx = 0;
-        apply_forward(ctx, lookup);
+        apply_forward(ctx, lookup, &mut counters);
 
         if !T::IN_PLACE {
             ctx.buffer.sync();
@@ -328,33 +355,46 @@ fn apply_string<T: LayoutTable>(ctx: &mut OT::hb_ot_apply_context_t, lookup: &T:
         assert!(!ctx.buffer.have_output);
 
         ctx.buffer.idx = ctx.buffer.len - 1;
-        apply_backward(ctx, lookup);
+        apply_backward(ctx, lookup, &mut counters);
     }
+
+    counters.record(ctx.buffer, T::INDEX, ctx.lookup_index, digest_glyphs);
 }
 
-fn apply_forward(ctx: &mut OT::hb_ot_apply_context_t, lookup: &impl Apply) -> bool {
+fn apply_forward(
+    ctx: &mut OT::hb_ot_apply_context_t,
+    lookup: &impl Apply,
+    counters: &mut hb_lookup_counters_t,
+) -> bool {
     let mut ret = false;
     while ctx.buffer.idx < ctx.buffer.len && ctx.buffer.successful {
         let cur = ctx.buffer.cur(0);
-        if (cur.mask & ctx.lookup_mask()) != 0
-            && ctx.check_glyph_property(cur, ctx.lookup_props)
-            && lookup.apply(ctx).is_some()
-        {
-            ret = true;
-        } else {
-            ctx.buffer.next_glyph();
+        if (cur.mask & ctx.lookup_mask()) != 0 && ctx.check_glyph_property(cur, ctx.lookup_props) {
+            let matched = lookup.apply(ctx).is_some();
+            counters.count(matched);
+            if matched {
+                ret = true;
+                continue;
+            }
         }
+        ctx.buffer.next_glyph();
     }
     ret
 }
 
-fn apply_backward(ctx: &mut OT::hb_ot_apply_context_t, lookup: &impl Apply) -> bool {
+fn apply_backward(
+    ctx: &mut OT::hb_ot_apply_context_t,
+    lookup: &impl Apply,
+    counters: &mut hb_lookup_counters_t,
+) -> bool {
     let mut ret = false;
     loop {
         let cur = ctx.buffer.cur(0);
-        ret |= (cur.mask & ctx.lookup_mask()) != 0
-            && ctx.check_glyph_property(cur, ctx.lookup_props)
-            && lookup.apply(ctx).is_some();
+        if (cur.mask & ctx.lookup_mask()) != 0 && ctx.check_glyph_property(cur, ctx.lookup_props) {
+            let matched = lookup.apply(ctx).is_some();
+            counters.count(matched);
+            ret |= matched;
+        }
 
         if ctx.buffer.idx == 0 {
             break;
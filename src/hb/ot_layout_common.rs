@@ -1,8 +1,10 @@
+use crate::hb::fonta::once_cell::OnceCell;
 use crate::hb::set_digest::{hb_set_digest_ext, hb_set_digest_t};
+use alloc::boxed::Box;
 use alloc::vec::Vec;
 use ttf_parser::gpos::PositioningSubtable;
 use ttf_parser::gsub::SubstitutionSubtable;
-use ttf_parser::opentype_layout::{Coverage, Lookup};
+use ttf_parser::opentype_layout::{Coverage, Lookup, LookupIndex};
 
 #[allow(dead_code)]
 pub mod lookup_flags {
@@ -15,22 +17,30 @@ pub mod lookup_flags {
     pub const MARK_ATTACHMENT_TYPE_MASK: u16 = 0xFF00;
 }
 
-#[derive(Clone)]
+/// Creates the cells of the lazily parsed lookups of a table.
+fn lookup_cells<T>(inner: &ttf_parser::opentype_layout::LayoutTable) -> Box<[OnceCell<Option<T>>]> {
+    (0..inner.lookups.len()).map(|_| OnceCell::new()).collect()
+}
+
 pub struct PositioningTable<'a> {
     pub inner: ttf_parser::opentype_layout::LayoutTable<'a>,
-    pub lookups: Vec<PositioningLookup<'a>>,
+    // Most lookups are applied through `fonta`, so these are only parsed on first use.
+    lookups: Box<[OnceCell<Option<PositioningLookup<'a>>>]>,
 }
 
 impl<'a> PositioningTable<'a> {
     pub fn new(inner: ttf_parser::opentype_layout::LayoutTable<'a>) -> Self {
-        let lookups = inner
-            .lookups
-            .into_iter()
-            .map(PositioningLookup::parse)
-            .collect();
-
+        let lookups = lookup_cells(&inner);
         Self { inner, lookups }
     }
+
+    /// Returns the lookup at `index`, parsing it on first access.
+    pub fn lookup(&self, index: LookupIndex) -> Option<&PositioningLookup<'a>> {
+        self.lookups
+            .get(usize::from(index))?
+            .get_or_init(|| self.inner.lookups.get(index).map(PositioningLookup::parse))
+            .as_ref()
+    }
 }
 
 pub trait CoverageExt {
@@ -80,18 +90,25 @@ impl<'a> PositioningLookup<'a> {
     }
 }
 
-#[derive(Clone)]
 pub struct SubstitutionTable<'a> {
     pub inner: ttf_parser::opentype_layout::LayoutTable<'a>,
-    pub lookups: Vec<SubstLookup<'a>>,
+    // Most lookups are applied through `fonta`, so these are only parsed on first use.
+    lookups: Box<[OnceCell<Option<SubstLookup<'a>>>]>,
 }
 
 impl<'a> SubstitutionTable<'a> {
     pub fn new(inner: ttf_parser::opentype_layout::LayoutTable<'a>) -> Self {
-        let lookups = inner.lookups.into_iter().map(SubstLookup::parse).collect();
-
+        let lookups = lookup_cells(&inner);
         Self { inner, lookups }
     }
+
+    /// Returns the lookup at `index`, parsing it on first access.
+    pub fn lookup(&self, index: LookupIndex) -> Option<&SubstLookup<'a>> {
+        self.lookups
+            .get(usize::from(index))?
+            .get_or_init(|| self.inner.lookups.get(index).map(SubstLookup::parse))
+            .as_ref()
+    }
 }
 
 #[derive(Clone)]
@@ -17,8 +17,8 @@ pub fn position(plan: &hb_ot_shape_plan_t, face: &hb_font_t, buffer: &mut hb_buf
         plan,
         face,
         buffer,
-        face.gpos.as_ref(),
-        face.font.ot.gpos.as_ref(),
+        face.face_data.gpos.as_ref(),
+        face.font.tables.ot.gpos.as_ref(),
     );
 }
 
@@ -149,7 +149,7 @@ impl<'a> LayoutTable for PositioningTable<'a> {
     type Lookup = PositioningLookup<'a>;
 
     fn get_lookup(&self, index: LookupIndex) -> Option<&Self::Lookup> {
-        self.lookups.get(usize::from(index))
+        self.lookup(index)
     }
 }
 
@@ -15,8 +15,8 @@ pub fn substitute(plan: &hb_ot_shape_plan_t, face: &hb_font_t, buffer: &mut hb_b
         plan,
         face,
         buffer,
-        face.gsub.as_ref(),
-        face.font.ot.gsub.as_ref(),
+        face.face_data.gsub.as_ref(),
+        face.font.tables.ot.gsub.as_ref(),
     );
 }
 
@@ -27,7 +27,7 @@ impl<'a> LayoutTable for SubstitutionTable<'a> {
     type Lookup = SubstLookup<'a>;
 
     fn get_lookup(&self, index: LookupIndex) -> Option<&Self::Lookup> {
-        self.lookups.get(usize::from(index))
+        self.lookup(index)
     }
 }
 
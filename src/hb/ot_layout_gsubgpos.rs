@@ -20,7 +20,7 @@ pub fn match_glyph(glyph: GlyphId, value: u16) -> bool {
 pub fn match_input(
     ctx: &mut hb_ot_apply_context_t,
     input_len: u16,
-    match_func: &match_func_t,
+    match_func: impl match_func_t,
     end_position: &mut usize,
     match_positions: &mut smallvec::SmallVec<[usize; 4]>,
     p_total_component_count: Option<&mut u8>,
@@ -63,9 +63,8 @@ pub fn match_input(
         match_positions.resize(count, 0);
     }
 
-    let mut iter = skipping_iterator_t::new(ctx, ctx.buffer.idx, false);
+    let mut iter = skipping_iterator_t::new(ctx, ctx.buffer.idx, false).with_matching(match_func);
     iter.set_glyph_data(0);
-    iter.enable_matching(match_func);
 
     let first = ctx.buffer.cur(0);
     let first_lig_id = _hb_glyph_info_get_lig_id(first);
@@ -144,12 +143,12 @@ pub fn match_input(
 pub fn match_backtrack(
     ctx: &mut hb_ot_apply_context_t,
     backtrack_len: u16,
-    match_func: &match_func_t,
+    match_func: impl match_func_t,
     match_start: &mut usize,
 ) -> bool {
-    let mut iter = skipping_iterator_t::new(ctx, ctx.buffer.backtrack_len(), true);
+    let mut iter =
+        skipping_iterator_t::new(ctx, ctx.buffer.backtrack_len(), true).with_matching(match_func);
     iter.set_glyph_data(0);
-    iter.enable_matching(match_func);
 
     for _ in 0..backtrack_len {
         let mut unsafe_from = 0;
@@ -166,13 +165,12 @@ pub fn match_backtrack(
 pub fn match_lookahead(
     ctx: &mut hb_ot_apply_context_t,
     lookahead_len: u16,
-    match_func: &match_func_t,
+    match_func: impl match_func_t,
     start_index: usize,
     end_index: &mut usize,
 ) -> bool {
-    let mut iter = skipping_iterator_t::new(ctx, start_index - 1, true);
+    let mut iter = skipping_iterator_t::new(ctx, start_index - 1, true).with_matching(match_func);
     iter.set_glyph_data(0);
-    iter.enable_matching(match_func);
 
     for _ in 0..lookahead_len {
         let mut unsafe_to = 0;
@@ -186,7 +184,21 @@ pub fn match_lookahead(
     true
 }
 
-pub type match_func_t<'a> = dyn Fn(GlyphId, u16) -> bool + 'a;
+/// Matches a glyph against a value of a rule, like a glyph id, a class or a coverage index.
+///
+/// Matchers are generic parameters rather than trait objects, so that the skipping iterator and
+/// the context matching functions are specialized for each kind of value.
+pub trait match_func_t: Fn(GlyphId, u16) -> bool {}
+
+impl<F: Fn(GlyphId, u16) -> bool> match_func_t for F {}
+
+// The matcher of a skipping iterator that doesn't match glyphs.
+pub type no_match_func_t = fn(GlyphId, u16) -> bool;
+
+// Lookup flags that make `check_glyph_property` look at the glyph props.
+const CHECKED_LOOKUP_FLAGS: u16 = lookup_flags::IGNORE_FLAGS
+    | lookup_flags::USE_MARK_FILTERING_SET
+    | lookup_flags::MARK_ATTACHMENT_TYPE_MASK;
 
 // In harfbuzz, skipping iterator works quite differently than it works here. In harfbuzz,
 // hb_ot_apply_context contains a skipping iterator that itself contains another reference to
@@ -194,14 +206,16 @@ pub type match_func_t<'a> = dyn Fn(GlyphId, u16) -> bool + 'a;
 // we cannot copy this approach. Because of this, we basically create a new skipping iterator
 // when needed, and we do not have the `reset` and `init` methods that exist in harfbuzz. This makes
 // backporting related changes very hard, but it seems unavoidable, unfortunately.
-pub struct skipping_iterator_t<'a, 'b> {
+pub struct skipping_iterator_t<'a, 'b, M = no_match_func_t> {
     ctx: &'a hb_ot_apply_context_t<'a, 'b>,
     lookup_props: u32,
+    // Whether glyph props have to be checked at all, see `CHECKED_LOOKUP_FLAGS`.
+    check_props: bool,
     ignore_zwnj: bool,
     ignore_zwj: bool,
     mask: hb_mask_t,
     syllable: u8,
-    matching: Option<&'a match_func_t<'a>>,
+    matching: Option<M>,
     buf_len: usize,
     glyph_data: u16,
     pub(crate) buf_idx: usize,
@@ -237,6 +251,7 @@ impl<'a, 'b> skipping_iterator_t<'a, 'b> {
         skipping_iterator_t {
             ctx,
             lookup_props: ctx.lookup_props,
+            check_props: ctx.lookup_props as u16 & CHECKED_LOOKUP_FLAGS != 0,
             // Ignore ZWNJ if we are matching GPOS, or matching GSUB context and asked to.
             ignore_zwnj: ctx.table_index == TableIndex::GPOS || (context_match && ctx.auto_zwnj),
             // Ignore ZWJ if we are matching context, or asked to.
@@ -258,6 +273,25 @@ impl<'a, 'b> skipping_iterator_t<'a, 'b> {
         }
     }
 
+    /// Returns the iterator matching glyphs with `func`.
+    pub fn with_matching<M: match_func_t>(self, func: M) -> skipping_iterator_t<'a, 'b, M> {
+        skipping_iterator_t {
+            ctx: self.ctx,
+            lookup_props: self.lookup_props,
+            check_props: self.check_props,
+            ignore_zwnj: self.ignore_zwnj,
+            ignore_zwj: self.ignore_zwj,
+            mask: self.mask,
+            syllable: self.syllable,
+            matching: Some(func),
+            buf_len: self.buf_len,
+            glyph_data: self.glyph_data,
+            buf_idx: self.buf_idx,
+        }
+    }
+}
+
+impl<'a, 'b, M: match_func_t> skipping_iterator_t<'a, 'b, M> {
     pub fn set_glyph_data(&mut self, glyph_data: u16) {
         self.glyph_data = glyph_data
     }
@@ -268,10 +302,7 @@ impl<'a, 'b> skipping_iterator_t<'a, 'b> {
 
     pub fn set_lookup_props(&mut self, lookup_props: u32) {
         self.lookup_props = lookup_props;
-    }
-
-    pub fn enable_matching(&mut self, func: &'a match_func_t<'a>) {
-        self.matching = Some(func);
+        self.check_props = lookup_props as u16 & CHECKED_LOOKUP_FLAGS != 0;
     }
 
     pub fn index(&self) -> usize {
@@ -368,7 +399,7 @@ impl<'a, 'b> skipping_iterator_t<'a, 'b> {
             return may_match_t::MATCH_NO;
         }
 
-        if let Some(match_func) = self.matching {
+        if let Some(match_func) = &self.matching {
             return if match_func(info.as_glyph(), self.glyph_data) {
                 may_match_t::MATCH_YES
             } else {
@@ -380,7 +411,8 @@ impl<'a, 'b> skipping_iterator_t<'a, 'b> {
     }
 
     fn may_skip(&self, info: &hb_glyph_info_t) -> may_skip_t {
-        if !self.ctx.check_glyph_property(info, self.lookup_props) {
+        // Most contextual lookups have no lookup flags, so don't even look at the glyph props.
+        if self.check_props && !self.ctx.check_glyph_property(info, self.lookup_props) {
             return may_skip_t::SKIP_YES;
         }
 
@@ -447,7 +479,7 @@ impl Apply for ContextLookup<'_> {
                 coverage.get(glyph)?;
                 let coverages_len = coverages.len();
 
-                let match_func = |glyph, index| {
+                let match_func = |glyph: GlyphId, index: u16| {
                     let coverage = coverages.get(index).unwrap();
                     coverage.get(glyph).is_some()
                 };
@@ -484,17 +516,17 @@ impl Apply for ContextLookup<'_> {
 }
 
 trait SequenceRuleSetExt {
-    fn would_apply(&self, ctx: &WouldApplyContext, match_func: &match_func_t) -> bool;
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t, match_func: &match_func_t) -> Option<()>;
+    fn would_apply(&self, ctx: &WouldApplyContext, match_func: &impl match_func_t) -> bool;
+    fn apply(&self, ctx: &mut hb_ot_apply_context_t, match_func: &impl match_func_t) -> Option<()>;
 }
 
 impl SequenceRuleSetExt for SequenceRuleSet<'_> {
-    fn would_apply(&self, ctx: &WouldApplyContext, match_func: &match_func_t) -> bool {
+    fn would_apply(&self, ctx: &WouldApplyContext, match_func: &impl match_func_t) -> bool {
         self.into_iter()
             .any(|rule| rule.would_apply(ctx, match_func))
     }
 
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t, match_func: &match_func_t) -> Option<()> {
+    fn apply(&self, ctx: &mut hb_ot_apply_context_t, match_func: &impl match_func_t) -> Option<()> {
         if self
             .into_iter()
             .any(|rule| rule.apply(ctx, match_func).is_some())
@@ -507,12 +539,12 @@ impl SequenceRuleSetExt for SequenceRuleSet<'_> {
 }
 
 trait SequenceRuleExt {
-    fn would_apply(&self, ctx: &WouldApplyContext, match_func: &match_func_t) -> bool;
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t, match_func: &match_func_t) -> Option<()>;
+    fn would_apply(&self, ctx: &WouldApplyContext, match_func: &impl match_func_t) -> bool;
+    fn apply(&self, ctx: &mut hb_ot_apply_context_t, match_func: &impl match_func_t) -> Option<()>;
 }
 
 impl SequenceRuleExt for SequenceRule<'_> {
-    fn would_apply(&self, ctx: &WouldApplyContext, match_func: &match_func_t) -> bool {
+    fn would_apply(&self, ctx: &WouldApplyContext, match_func: &impl match_func_t) -> bool {
         ctx.glyphs.len() == usize::from(self.input.len()) + 1
             && self
                 .input
@@ -521,7 +553,7 @@ impl SequenceRuleExt for SequenceRule<'_> {
                 .all(|(i, value)| match_func(ctx.glyphs[i + 1], value))
     }
 
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t, match_func: &match_func_t) -> Option<()> {
+    fn apply(&self, ctx: &mut hb_ot_apply_context_t, match_func: &impl match_func_t) -> Option<()> {
         apply_context(ctx, self.input, match_func, self.lookups)
 
         // TODO: Port optimized version from https://github.com/harfbuzz/harfbuzz/commit/645fabd10
@@ -571,7 +603,7 @@ impl Apply for ChainedContextLookup<'_> {
             Self::Format1 { coverage, sets } => {
                 let index = coverage.get(glyph)?;
                 let set = sets.get(index)?;
-                set.apply(ctx, [&match_glyph, &match_glyph, &match_glyph])
+                set.apply(ctx, (&match_glyph, &match_glyph, &match_glyph))
             }
             Self::Format2 {
                 coverage,
@@ -585,11 +617,11 @@ impl Apply for ChainedContextLookup<'_> {
                 let set = sets.get(class)?;
                 set.apply(
                     ctx,
-                    [
+                    (
                         &match_class(backtrack_classes),
                         &match_class(input_classes),
                         &match_class(lookahead_classes),
-                    ],
+                    ),
                 )
             }
             Self::Format3 {
@@ -601,17 +633,17 @@ impl Apply for ChainedContextLookup<'_> {
             } => {
                 coverage.get(glyph)?;
 
-                let back = |glyph, index| {
+                let back = |glyph: GlyphId, index: u16| {
                     let coverage = backtrack_coverages.get(index).unwrap();
                     coverage.contains(glyph)
                 };
 
-                let ahead = |glyph, index| {
+                let ahead = |glyph: GlyphId, index: u16| {
                     let coverage = lookahead_coverages.get(index).unwrap();
                     coverage.contains(glyph)
                 };
 
-                let input = |glyph, index| {
+                let input = |glyph: GlyphId, index: u16| {
                     let coverage = input_coverages.get(index).unwrap();
                     coverage.contains(glyph)
                 };
@@ -672,13 +704,16 @@ impl Apply for ChainedContextLookup<'_> {
 }
 
 trait ChainRuleSetExt {
-    fn would_apply(&self, ctx: &WouldApplyContext, match_func: &match_func_t) -> bool;
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t, match_funcs: [&match_func_t; 3])
-        -> Option<()>;
+    fn would_apply(&self, ctx: &WouldApplyContext, match_func: &impl match_func_t) -> bool;
+    fn apply(
+        &self,
+        ctx: &mut hb_ot_apply_context_t,
+        match_funcs: (&impl match_func_t, &impl match_func_t, &impl match_func_t),
+    ) -> Option<()>;
 }
 
 impl ChainRuleSetExt for ChainedSequenceRuleSet<'_> {
-    fn would_apply(&self, ctx: &WouldApplyContext, match_func: &match_func_t) -> bool {
+    fn would_apply(&self, ctx: &WouldApplyContext, match_func: &impl match_func_t) -> bool {
         self.into_iter()
             .any(|rule| rule.would_apply(ctx, match_func))
     }
@@ -686,7 +721,7 @@ impl ChainRuleSetExt for ChainedSequenceRuleSet<'_> {
     fn apply(
         &self,
         ctx: &mut hb_ot_apply_context_t,
-        match_funcs: [&match_func_t; 3],
+        match_funcs: (&impl match_func_t, &impl match_func_t, &impl match_func_t),
     ) -> Option<()> {
         if self
             .into_iter()
@@ -702,13 +737,16 @@ impl ChainRuleSetExt for ChainedSequenceRuleSet<'_> {
 }
 
 trait ChainRuleExt {
-    fn would_apply(&self, ctx: &WouldApplyContext, match_func: &match_func_t) -> bool;
-    fn apply(&self, ctx: &mut hb_ot_apply_context_t, match_funcs: [&match_func_t; 3])
-        -> Option<()>;
+    fn would_apply(&self, ctx: &WouldApplyContext, match_func: &impl match_func_t) -> bool;
+    fn apply(
+        &self,
+        ctx: &mut hb_ot_apply_context_t,
+        match_funcs: (&impl match_func_t, &impl match_func_t, &impl match_func_t),
+    ) -> Option<()>;
 }
 
 impl ChainRuleExt for ChainedSequenceRule<'_> {
-    fn would_apply(&self, ctx: &WouldApplyContext, match_func: &match_func_t) -> bool {
+    fn would_apply(&self, ctx: &WouldApplyContext, match_func: &impl match_func_t) -> bool {
         (!ctx.zero_context || (self.backtrack.len() == 0 && self.lookahead.len() == 0))
             && (ctx.glyphs.len() == usize::from(self.input.len()) + 1
                 && self
@@ -721,7 +759,7 @@ impl ChainRuleExt for ChainedSequenceRule<'_> {
     fn apply(
         &self,
         ctx: &mut hb_ot_apply_context_t,
-        match_funcs: [&match_func_t; 3],
+        match_funcs: (&impl match_func_t, &impl match_func_t, &impl match_func_t),
     ) -> Option<()> {
         apply_chain_context(
             ctx,
@@ -737,10 +775,10 @@ impl ChainRuleExt for ChainedSequenceRule<'_> {
 fn apply_context(
     ctx: &mut hb_ot_apply_context_t,
     input: LazyArray16<u16>,
-    match_func: &match_func_t,
+    match_func: &impl match_func_t,
     lookups: LazyArray16<SequenceLookupRecord>,
 ) -> Option<()> {
-    let match_func = |glyph, index| {
+    let match_func = |glyph: GlyphId, index: u16| {
         let value = input.get(index).unwrap();
         match_func(glyph, value)
     };
@@ -776,24 +814,24 @@ fn apply_chain_context(
     backtrack: LazyArray16<u16>,
     input: LazyArray16<u16>,
     lookahead: LazyArray16<u16>,
-    match_funcs: [&match_func_t; 3],
+    match_funcs: (&impl match_func_t, &impl match_func_t, &impl match_func_t),
     lookups: LazyArray16<SequenceLookupRecord>,
 ) -> Option<()> {
     // NOTE: Whenever something in this method changes, we also need to
     // change it in the `apply` implementation for ChainedContextLookup.
-    let f1 = |glyph, index| {
+    let f1 = |glyph: GlyphId, index: u16| {
         let value = backtrack.get(index).unwrap();
-        match_funcs[0](glyph, value)
+        (match_funcs.0)(glyph, value)
     };
 
-    let f2 = |glyph, index| {
+    let f2 = |glyph: GlyphId, index: u16| {
         let value = lookahead.get(index).unwrap();
-        match_funcs[2](glyph, value)
+        (match_funcs.2)(glyph, value)
     };
 
-    let f3 = |glyph, index| {
+    let f3 = |glyph: GlyphId, index: u16| {
         let value = input.get(index).unwrap();
-        match_funcs[1](glyph, value)
+        (match_funcs.1)(glyph, value)
     };
 
     let mut end_index = ctx.buffer.idx;
@@ -1085,6 +1123,7 @@ pub mod OT {
                     if let Some(lookup) = self
                         .face
                         .font
+                        .tables
                         .ot
                         .gsub
                         .as_ref()
@@ -1094,6 +1133,7 @@ pub mod OT {
                         lookup.apply(self)
                     } else {
                         self.face
+                            .face_data
                             .gsub
                             .as_ref()
                             .and_then(|table| table.get_lookup(sub_lookup_index))
@@ -1107,6 +1147,7 @@ pub mod OT {
                     if let Some(lookup) = self
                         .face
                         .font
+                        .tables
                         .ot
                         .gpos
                         .as_ref()
@@ -1116,6 +1157,7 @@ pub mod OT {
                         lookup.apply(self)
                     } else {
                         self.face
+                            .face_data
                             .gpos
                             .as_ref()
                             .and_then(|table| table.get_lookup(sub_lookup_index))
@@ -1150,14 +1192,12 @@ pub mod OT {
                 // match_props has the set index.
                 if lookup_flags & lookup_flags::USE_MARK_FILTERING_SET != 0 {
                     let set_index = (match_props >> 16) as u16;
-                    // TODO: harfbuzz uses a digest here to speed things up if HB_NO_GDEF_CACHE
-                    // is enabled. But a bit harder to implement for us since it's taken care of by
-                    // ttf-parser
-                    if let Some(table) = self.face.tables().gdef {
-                        return table.is_mark_glyph(info.as_glyph(), Some(set_index));
-                    } else {
-                        return false;
-                    }
+                    return self
+                        .face
+                        .font
+                        .tables
+                        .ot
+                        .is_mark_glyph(info.glyph_id, set_index);
                 }
 
                 // The second byte of match_props has the meaning
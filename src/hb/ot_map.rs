@@ -9,7 +9,7 @@ use ttf_parser::opentype_layout::{
 
 use super::buffer::{glyph_flag, hb_buffer_t};
 use super::ot_layout::{LayoutTableExt, TableIndex};
-use super::ot_shape_plan::hb_ot_shape_plan_t;
+use super::ot_shape_plan::{hb_ot_shape_plan_t, hb_plan_reader_t};
 use super::{hb_font_t, hb_mask_t, hb_tag_t, tag, Language, Script};
 
 pub struct hb_ot_map_t {
@@ -64,13 +64,92 @@ pub struct lookup_map_t {
 pub struct StageMap {
     // Cumulative
     pub last_lookup: usize,
-    pub pause_func: Option<pause_func_t>,
+    pub pause: Option<pause_t>,
 }
 
 // Pause functions return true if new glyph indices might have been added to the buffer.
 // This is used to update buffer digest.
 pub type pause_func_t = fn(&hb_ot_shape_plan_t, &hb_font_t, &mut hb_buffer_t) -> bool;
 
+/// The pause functions of all shapers.
+///
+/// Stages store these instead of function pointers, so that a serialized plan can refer
+/// to them by value. The values are part of the plan format and must not change.
+#[derive(Clone, Copy, PartialEq, Eq, Debug)]
+#[repr(u8)]
+pub enum pause_t {
+    SyllabicClearVar = 1,
+    ClearSubstitutionFlags = 2,
+    ArabicRecordStch = 3,
+    ArabicFallbackShape = 4,
+    IndicSetupSyllables = 5,
+    IndicInitialReordering = 6,
+    IndicFinalReordering = 7,
+    KhmerSetupSyllables = 8,
+    KhmerReorder = 9,
+    MyanmarSetupSyllables = 10,
+    MyanmarReorder = 11,
+    UseSetupSyllables = 12,
+    UseRecordRphf = 13,
+    UseRecordPref = 14,
+    UseReorder = 15,
+}
+
+impl pause_t {
+    const ALL: [pause_t; 15] = [
+        pause_t::SyllabicClearVar,
+        pause_t::ClearSubstitutionFlags,
+        pause_t::ArabicRecordStch,
+        pause_t::ArabicFallbackShape,
+        pause_t::IndicSetupSyllables,
+        pause_t::IndicInitialReordering,
+        pause_t::IndicFinalReordering,
+        pause_t::KhmerSetupSyllables,
+        pause_t::KhmerReorder,
+        pause_t::MyanmarSetupSyllables,
+        pause_t::MyanmarReorder,
+        pause_t::UseSetupSyllables,
+        pause_t::UseRecordRphf,
+        pause_t::UseRecordPref,
+        pause_t::UseReorder,
+    ];
+
+    fn from_u8(value: u8) -> Option<Self> {
+        Self::ALL.into_iter().find(|pause| *pause as u8 == value)
+    }
+
+    /// Runs the pause function, see `pause_func_t`.
+    pub fn apply(
+        self,
+        plan: &hb_ot_shape_plan_t,
+        face: &hb_font_t,
+        buffer: &mut hb_buffer_t,
+    ) -> bool {
+        use super::{
+            ot_shaper_arabic, ot_shaper_indic, ot_shaper_khmer, ot_shaper_myanmar, ot_shaper_use,
+        };
+
+        let func: pause_func_t = match self {
+            pause_t::SyllabicClearVar => super::ot_shape::syllabic_clear_var,
+            pause_t::ClearSubstitutionFlags => super::ot_layout::_hb_clear_substitution_flags,
+            pause_t::ArabicRecordStch => ot_shaper_arabic::record_stch,
+            pause_t::ArabicFallbackShape => ot_shaper_arabic::arabic_fallback_shape,
+            pause_t::IndicSetupSyllables => ot_shaper_indic::setup_syllables,
+            pause_t::IndicInitialReordering => ot_shaper_indic::initial_reordering,
+            pause_t::IndicFinalReordering => ot_shaper_indic::final_reordering,
+            pause_t::KhmerSetupSyllables => ot_shaper_khmer::setup_syllables,
+            pause_t::KhmerReorder => ot_shaper_khmer::reorder_khmer,
+            pause_t::MyanmarSetupSyllables => ot_shaper_myanmar::setup_syllables,
+            pause_t::MyanmarReorder => ot_shaper_myanmar::reorder_myanmar,
+            pause_t::UseSetupSyllables => ot_shaper_use::setup_syllables,
+            pause_t::UseRecordRphf => ot_shaper_use::record_rphf,
+            pause_t::UseRecordPref => ot_shaper_use::record_pref,
+            pause_t::UseReorder => ot_shaper_use::reorder_use,
+        };
+        func(plan, face, buffer)
+    }
+}
+
 impl hb_ot_map_t {
     pub const MAX_BITS: u32 = 8;
     pub const MAX_VALUE: u32 = (1 << Self::MAX_BITS) - 1;
@@ -135,6 +214,11 @@ impl hb_ot_map_t {
         &self.stages[table_index]
     }
 
+    #[inline]
+    pub fn lookups(&self, table_index: TableIndex) -> &[lookup_map_t] {
+        &self.lookups[table_index]
+    }
+
     #[inline]
     pub fn lookup(&self, table_index: TableIndex, index: usize) -> &lookup_map_t {
         &self.lookups[table_index][index]
@@ -159,6 +243,192 @@ impl hb_ot_map_t {
     }
 }
 
+const FEATURE_AUTO_ZWNJ: u8 = 1 << 0;
+const FEATURE_AUTO_ZWJ: u8 = 1 << 1;
+const FEATURE_RANDOM: u8 = 1 << 2;
+const FEATURE_PER_SYLLABLE: u8 = 1 << 3;
+
+fn feature_flags(auto_zwnj: bool, auto_zwj: bool, random: bool, per_syllable: bool) -> u8 {
+    u8::from(auto_zwnj) * FEATURE_AUTO_ZWNJ
+        | u8::from(auto_zwj) * FEATURE_AUTO_ZWJ
+        | u8::from(random) * FEATURE_RANDOM
+        | u8::from(per_syllable) * FEATURE_PER_SYLLABLE
+}
+
+fn write_tag(out: &mut Vec<u8>, tag: Option<hb_tag_t>) {
+    // Tags are never null, which leaves zero for `None`.
+    out.extend_from_slice(&tag.map_or(0, |tag| tag.as_u32()).to_le_bytes());
+}
+
+fn read_tag(r: &mut hb_plan_reader_t) -> Option<Option<hb_tag_t>> {
+    let tag = r.u32()?;
+    Some((tag != 0).then(|| hb_tag_t(tag)))
+}
+
+fn write_index(out: &mut Vec<u8>, index: Option<u16>) {
+    match index {
+        Some(index) => {
+            out.push(1);
+            out.extend_from_slice(&index.to_le_bytes());
+        }
+        None => out.push(0),
+    }
+}
+
+fn read_index(r: &mut hb_plan_reader_t) -> Option<Option<u16>> {
+    match r.u8()? {
+        0 => Some(None),
+        1 => Some(Some(r.u16()?)),
+        _ => None,
+    }
+}
+
+impl hb_ot_map_t {
+    /// Appends the map to `out`, see `hb_ot_shape_plan_t::to_bytes`.
+    pub(crate) fn write(&self, out: &mut Vec<u8>) {
+        for table_index in TableIndex::iter() {
+            out.push(u8::from(self.found_script[table_index]));
+            write_tag(out, self.chosen_script[table_index]);
+        }
+        out.extend_from_slice(&self.global_mask.to_le_bytes());
+
+        out.extend_from_slice(&(self.features.len() as u32).to_le_bytes());
+        for feature in &self.features {
+            write_tag(out, Some(feature.tag));
+            for table_index in TableIndex::iter() {
+                write_index(out, feature.index[table_index]);
+                out.extend_from_slice(&(feature.stage[table_index] as u32).to_le_bytes());
+            }
+            out.push(feature.shift as u8);
+            out.extend_from_slice(&feature.mask.to_le_bytes());
+            out.push(feature_flags(
+                feature.auto_zwnj,
+                feature.auto_zwj,
+                feature.random,
+                feature.per_syllable,
+            ));
+        }
+
+        for table_index in TableIndex::iter() {
+            let lookups = &self.lookups[table_index];
+            out.extend_from_slice(&(lookups.len() as u32).to_le_bytes());
+            for lookup in lookups {
+                out.extend_from_slice(&lookup.index.to_le_bytes());
+                out.extend_from_slice(&lookup.mask.to_le_bytes());
+                out.push(feature_flags(
+                    lookup.auto_zwnj,
+                    lookup.auto_zwj,
+                    lookup.random,
+                    lookup.per_syllable,
+                ));
+            }
+
+            let stages = &self.stages[table_index];
+            out.extend_from_slice(&(stages.len() as u32).to_le_bytes());
+            for stage in stages {
+                out.extend_from_slice(&(stage.last_lookup as u32).to_le_bytes());
+                out.push(stage.pause.map_or(0, |pause| pause as u8));
+            }
+        }
+    }
+
+    /// Reads a map written by `write`.
+    ///
+    /// Returns `None` if the data is malformed, so that shaping with the result can't panic.
+    pub(crate) fn read(r: &mut hb_plan_reader_t) -> Option<Self> {
+        let mut found_script = [false; 2];
+        let mut chosen_script = [None; 2];
+        for table_index in TableIndex::iter() {
+            found_script[table_index] = r.bool()?;
+            chosen_script[table_index] = read_tag(r)?;
+        }
+        let global_mask = r.u32()?;
+
+        let mut features = Vec::new();
+        for _ in 0..r.len(12)? {
+            let tag = read_tag(r)??;
+            let mut index = [None; 2];
+            let mut stage = [0; 2];
+            for table_index in TableIndex::iter() {
+                index[table_index] = read_index(r)?;
+                stage[table_index] = r.u32()? as usize;
+            }
+            let shift = u32::from(r.u8()?);
+            let mask = r.u32()?;
+            let flags = r.u8()?;
+            if shift >= 32 {
+                return None;
+            }
+            features.push(feature_map_t {
+                tag,
+                index,
+                stage,
+                shift,
+                mask,
+                one_mask: (1 << shift) & mask,
+                auto_zwnj: flags & FEATURE_AUTO_ZWNJ != 0,
+                auto_zwj: flags & FEATURE_AUTO_ZWJ != 0,
+                random: flags & FEATURE_RANDOM != 0,
+                per_syllable: flags & FEATURE_PER_SYLLABLE != 0,
+            });
+        }
+        // Masks are looked up by binary search.
+        if features.windows(2).any(|pair| pair[0].tag >= pair[1].tag) {
+            return None;
+        }
+
+        let mut lookups = [Vec::new(), Vec::new()];
+        let mut stages = [Vec::new(), Vec::new()];
+        for table_index in TableIndex::iter() {
+            for _ in 0..r.len(7)? {
+                let index = r.u16()?;
+                let mask = r.u32()?;
+                let flags = r.u8()?;
+                lookups[table_index].push(lookup_map_t {
+                    index,
+                    auto_zwnj: flags & FEATURE_AUTO_ZWNJ != 0,
+                    auto_zwj: flags & FEATURE_AUTO_ZWJ != 0,
+                    random: flags & FEATURE_RANDOM != 0,
+                    mask,
+                    per_syllable: flags & FEATURE_PER_SYLLABLE != 0,
+                });
+            }
+
+            let mut prev_last_lookup = 0;
+            for _ in 0..r.len(5)? {
+                let last_lookup = r.u32()? as usize;
+                let pause = match r.u8()? {
+                    0 => None,
+                    pause => Some(pause_t::from_u8(pause)?),
+                };
+                if last_lookup < prev_last_lookup || last_lookup > lookups[table_index].len() {
+                    return None;
+                }
+                prev_last_lookup = last_lookup;
+                stages[table_index].push(StageMap { last_lookup, pause });
+            }
+        }
+
+        // Stage ranges are used to slice the lookups.
+        for feature in &features {
+            for table_index in TableIndex::iter() {
+                if feature.stage[table_index] > stages[table_index].len() {
+                    return None;
+                }
+            }
+        }
+
+        Some(hb_ot_map_t {
+            found_script,
+            chosen_script,
+            global_mask,
+            features,
+            lookups,
+            stages,
+        })
+    }
+}
+
 pub type hb_ot_map_feature_flags_t = u32;
 pub const F_NONE: u32 = 0x0000;
 pub const F_GLOBAL: u32 = 0x0001; /* Feature applies to all characters; results in no mask allocated for it. */
@@ -200,7 +470,7 @@ struct feature_info_t {
 #[derive(Clone, Copy)]
 struct stage_info_t {
     index: usize,
-    pause_func: Option<pause_func_t>,
+    pause: Option<pause_t>,
 }
 
 const GLOBAL_BIT_SHIFT: u32 = 8 * u32::SIZE as u32 - 1;
@@ -293,19 +563,19 @@ impl<'a> hb_ot_map_builder_t<'a> {
     }
 
     #[inline]
-    pub fn add_gsub_pause(&mut self, pause: Option<pause_func_t>) {
+    pub fn add_gsub_pause(&mut self, pause: Option<pause_t>) {
         self.add_pause(TableIndex::GSUB, pause);
     }
 
     #[inline]
-    pub fn add_gpos_pause(&mut self, pause: Option<pause_func_t>) {
+    pub fn add_gpos_pause(&mut self, pause: Option<pause_t>) {
         self.add_pause(TableIndex::GPOS, pause);
     }
 
-    fn add_pause(&mut self, table_index: TableIndex, pause: Option<pause_func_t>) {
+    fn add_pause(&mut self, table_index: TableIndex, pause: Option<pause_t>) {
         self.stages[table_index].push(stage_info_t {
             index: self.current_stage[table_index],
-            pause_func: pause,
+            pause,
         });
 
         self.current_stage[table_index] += 1;
@@ -560,7 +830,7 @@ impl<'a> hb_ot_map_builder_t<'a> {
                     if info.index == stage {
                         map_stages[table_index].push(StageMap {
                             last_lookup,
-                            pause_func: info.pause_func,
+                            pause: info.pause,
                         });
 
                         stage_index += 1;
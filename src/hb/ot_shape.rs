@@ -4,6 +4,7 @@ use super::ot_layout_gpos_table::GPOS;
 use super::ot_map::*;
 use super::ot_shape_plan::hb_ot_shape_plan_t;
 use super::ot_shaper::*;
+use super::stats::{self, hb_shape_stage_t, hb_stage_timer_t};
 use super::unicode::{hb_unicode_general_category_t, CharExt, GeneralCategoryExt};
 use super::*;
 use super::{hb_font_t, hb_tag_t};
@@ -51,8 +52,8 @@ impl<'a> hb_ot_shape_planner_t<'a> {
         let script_fallback_mark_positioning = shaper.fallback_position;
 
         // https://github.com/harfbuzz/harfbuzz/issues/2124
-        let apply_morx =
-            face.tables().morx.is_some() && (direction.is_horizontal() || face.gsub.is_none());
+        let apply_morx = face.tables().morx.is_some()
+            && (direction.is_horizontal() || face.face_data.gsub.is_none());
 
         // https://github.com/harfbuzz/harfbuzz/issues/1528
         if apply_morx && shaper as *const _ != &DEFAULT_SHAPER as *const _ {
@@ -270,6 +271,19 @@ impl<'a> hb_ot_shape_planner_t<'a> {
         // Currently we always apply trak.
         let apply_trak = requested_tracking && self.face.tables().trak.is_some();
 
+        // ASCII-only runs can go straight from cmap to positioning when there is
+        // nothing to substitute and nothing for the shaper to reorder.
+        let ascii_fast_path = self.direction == Direction::LeftToRight
+            && self.script.and_then(Direction::from_script) != Some(Direction::RightToLeft)
+            && !apply_morx
+            && self.shaper.preprocess_text.is_none()
+            && self.shaper.decompose.is_none()
+            && ot_map.lookups(TableIndex::GSUB).is_empty()
+            && ot_map
+                .stages(TableIndex::GSUB)
+                .iter()
+                .all(|stage| stage.pause.is_none());
+
         let mut plan = hb_ot_shape_plan_t {
             direction: self.direction,
             script: self.script,
@@ -296,6 +310,7 @@ impl<'a> hb_ot_shape_planner_t<'a> {
             apply_kerx,
             apply_morx,
             apply_trak,
+            ascii_fast_path,
             user_features: user_features.to_vec(),
         };
 
@@ -317,10 +332,44 @@ pub struct hb_ot_shape_context_t<'a> {
 
 // Pull it all together!
 pub fn shape_internal(ctx: &mut hb_ot_shape_context_t) {
+    shape_begin(ctx);
+
+    let is_simple = ctx.plan.ascii_fast_path
+        && ctx.buffer.scratch_flags & HB_BUFFER_SCRATCH_FLAG_HAS_NON_ASCII == 0
+        && substitute_simple(ctx);
+
+    if !is_simple {
+        prepare_text(ctx);
+
+        let timer = hb_stage_timer_t::start(ctx.buffer);
+        substitute_pre(ctx);
+        timer.stop(ctx.buffer, hb_shape_stage_t::SubstitutePre);
+    }
+
+    let timer = hb_stage_timer_t::start(ctx.buffer);
+    position(ctx);
+    timer.stop(ctx.buffer, hb_shape_stage_t::Position);
+
+    let timer = hb_stage_timer_t::start(ctx.buffer);
+    substitute_post(ctx);
+    timer.stop(ctx.buffer, hb_shape_stage_t::SubstitutePost);
+
+    propagate_flags(ctx.buffer);
+
+    stats::finish(ctx.buffer);
+    ctx.buffer.direction = ctx.target_direction;
+    ctx.buffer.leave();
+}
+
+fn shape_begin(ctx: &mut hb_ot_shape_context_t) {
     ctx.buffer.enter();
+    stats::start(ctx.buffer);
 
     initialize_masks(ctx);
     set_unicode_props(ctx.buffer);
+}
+
+fn prepare_text(ctx: &mut hb_ot_shape_context_t) {
     insert_dotted_circle(ctx.buffer, ctx.face);
 
     form_clusters(ctx.buffer);
@@ -330,24 +379,39 @@ pub fn shape_internal(ctx: &mut hb_ot_shape_context_t) {
     if let Some(func) = ctx.plan.shaper.preprocess_text {
         func(ctx.plan, ctx.face, ctx.buffer);
     }
-
-    substitute_pre(ctx);
-    position(ctx);
-    substitute_post(ctx);
-
-    propagate_flags(ctx.buffer);
-
-    ctx.buffer.direction = ctx.target_direction;
-    ctx.buffer.leave();
 }
 
 fn substitute_pre(ctx: &mut hb_ot_shape_context_t) {
     hb_ot_substitute_default(ctx);
-    hb_ot_substitute_plan(ctx);
+    substitute_start(ctx);
+    substitute_glyphs(ctx);
+}
 
-    if ctx.plan.apply_morx && ctx.plan.apply_gpos {
-        hb_aat_layout_remove_deleted_glyphs(&mut ctx.buffer);
+// ASCII text has no marks, clusters to form or decompositions, so with
+// `ascii_fast_path` plans normalization reduces to a cmap lookup and GSUB
+// has nothing to do. Returns `false` if a character is missing from the font,
+// in which case the buffer is left as is, for the regular path to handle.
+fn substitute_simple(ctx: &mut hb_ot_shape_context_t) -> bool {
+    let len = ctx.buffer.len;
+    for i in 0..len {
+        let info = &mut ctx.buffer.info[i];
+        match ctx.face.get_nominal_glyph(info.glyph_id) {
+            Some(glyph_id) => info.set_glyph_index(u32::from(glyph_id.0)),
+            None => {
+                for info in &mut ctx.buffer.info[..i] {
+                    info.set_glyph_index(0);
+                }
+                return false;
+            }
+        }
     }
+
+    setup_masks(ctx);
+    map_glyphs_fast(ctx.buffer);
+
+    substitute_start(ctx);
+
+    true
 }
 
 fn substitute_post(ctx: &mut hb_ot_shape_context_t) {
@@ -365,8 +429,14 @@ fn substitute_post(ctx: &mut hb_ot_shape_context_t) {
 fn hb_ot_substitute_default(ctx: &mut hb_ot_shape_context_t) {
     rotate_chars(ctx);
 
+    let timer = hb_stage_timer_t::start(ctx.buffer);
     ot_shape_normalize::_hb_ot_shape_normalize(ctx.plan, ctx.buffer, ctx.face);
+    timer.stop(ctx.buffer, hb_shape_stage_t::Normalize);
 
+    prepare_glyphs(ctx);
+}
+
+fn prepare_glyphs(ctx: &mut hb_ot_shape_context_t) {
     setup_masks(ctx);
 
     // This is unfortunate to go here, but necessary...
@@ -379,26 +449,34 @@ fn hb_ot_substitute_default(ctx: &mut hb_ot_shape_context_t) {
     map_glyphs_fast(ctx.buffer);
 }
 
-fn hb_ot_substitute_plan(ctx: &mut hb_ot_shape_context_t) {
+fn substitute_start(ctx: &mut hb_ot_shape_context_t) {
     hb_ot_layout_substitute_start(ctx.face, ctx.buffer);
 
     if ctx.plan.fallback_glyph_classes {
         hb_synthesize_glyph_classes(ctx.buffer);
     }
+}
 
-    if ctx.plan.apply_morx {
-        aat_layout::hb_aat_layout_substitute(ctx.plan, ctx.face, ctx.buffer);
+fn substitute_glyphs(ctx: &mut hb_ot_shape_context_t) {
+    substitute_by_plan(ctx.plan, ctx.face, ctx.buffer);
+
+    if ctx.plan.apply_morx && ctx.plan.apply_gpos {
+        hb_aat_layout_remove_deleted_glyphs(ctx.buffer);
+    }
+}
+
+fn substitute_by_plan(plan: &hb_ot_shape_plan_t, face: &hb_font_t, buffer: &mut hb_buffer_t) {
+    if plan.apply_morx {
+        aat_layout::hb_aat_layout_substitute(plan, face, buffer);
     } else {
-        super::ot_layout_gsub_table::substitute(ctx.plan, ctx.face, ctx.buffer);
+        super::ot_layout_gsub_table::substitute(plan, face, buffer);
     }
 }
 
 fn position(ctx: &mut hb_ot_shape_context_t) {
-    ctx.buffer.clear_positions();
+    let adjust_offsets_when_zeroing = position_start(ctx);
 
-    position_default(ctx);
-
-    position_complex(ctx);
+    position_complex(ctx, adjust_offsets_when_zeroing);
 
     if ctx.buffer.direction.is_backward() {
         ctx.buffer.reverse();
@@ -432,7 +510,12 @@ fn position_default(ctx: &mut hb_ot_shape_context_t) {
     }
 }
 
-fn position_complex(ctx: &mut hb_ot_shape_context_t) {
+// Returns whether zeroing mark widths adjusts their offsets.
+fn position_start(ctx: &mut hb_ot_shape_context_t) -> bool {
+    ctx.buffer.clear_positions();
+
+    position_default(ctx);
+
     // If the font has no GPOS and direction is forward, then when
     // zeroing mark widths, we shift the mark with it, such that the
     // mark is positioned hanging over the previous glyph.  When
@@ -454,6 +537,10 @@ fn position_complex(ctx: &mut hb_ot_shape_context_t) {
         zero_mark_widths_by_gdef(ctx.buffer, adjust_offsets_when_zeroing);
     }
 
+    adjust_offsets_when_zeroing
+}
+
+fn position_complex(ctx: &mut hb_ot_shape_context_t, adjust_offsets_when_zeroing: bool) {
     position_by_plan(ctx.plan, ctx.face, ctx.buffer);
 
     if ctx.plan.zero_marks
@@ -483,20 +570,28 @@ fn position_complex(ctx: &mut hb_ot_shape_context_t) {
 }
 
 fn position_by_plan(plan: &hb_ot_shape_plan_t, face: &hb_font_t, buffer: &mut hb_buffer_t) {
+    position_layout(plan, face, buffer);
+    position_kern(plan, face, buffer);
+
+    if plan.apply_trak {
+        aat_layout::hb_aat_layout_track(plan, face, buffer);
+    }
+}
+
+fn position_layout(plan: &hb_ot_shape_plan_t, face: &hb_font_t, buffer: &mut hb_buffer_t) {
     if plan.apply_gpos {
         super::ot_layout_gpos_table::position(plan, face, buffer);
     } else if plan.apply_kerx {
         aat_layout::hb_aat_layout_position(plan, face, buffer);
     }
+}
+
+fn position_kern(plan: &hb_ot_shape_plan_t, face: &hb_font_t, buffer: &mut hb_buffer_t) {
     if plan.apply_kern {
         super::kerning::hb_ot_layout_kern(plan, face, buffer);
     } else if plan.apply_fallback_kern {
         ot_shape_fallback::_hb_ot_shape_fallback_kern(plan, face, buffer);
     }
-
-    if plan.apply_trak {
-        aat_layout::hb_aat_layout_track(plan, face, buffer);
-    }
 }
 
 fn initialize_masks(ctx: &mut hb_ot_shape_context_t) {
@@ -946,3 +1041,86 @@ fn propagate_flags(buffer: &mut hb_buffer_t) {
         }
     });
 }
+
+/// Helpers for benchmarking individual shaping stages.
+///
+/// Not a stable API.
+#[cfg(feature = "bench")]
+pub mod bench {
+    use super::*;
+    use crate::UnicodeBuffer;
+
+    /// A shaping stage.
+    #[derive(Clone, Copy, PartialEq, Eq, Debug)]
+    pub enum Stage {
+        /// Unicode normalization, including the cmap lookup.
+        Normalize,
+        /// GSUB, or `morx` if the plan uses it.
+        Substitute,
+        /// GPOS, or `kerx` if the plan uses it.
+        Position,
+        /// The `kern` table, or fallback kerning.
+        Kern,
+    }
+
+    /// A buffer in the state right before a shaping stage.
+    #[derive(Clone)]
+    pub struct StageInput {
+        buffer: hb_buffer_t,
+        stage: Stage,
+    }
+
+    impl StageInput {
+        /// Runs the shaping steps preceding `stage` on `buffer`.
+        pub fn new(
+            face: &hb_font_t,
+            plan: &hb_ot_shape_plan_t,
+            buffer: UnicodeBuffer,
+            stage: Stage,
+        ) -> Self {
+            let mut buffer = buffer.0;
+            buffer.guess_segment_properties();
+            let target_direction = buffer.direction;
+            let ctx = &mut hb_ot_shape_context_t {
+                plan,
+                face,
+                buffer: &mut buffer,
+                target_direction,
+            };
+
+            // The same steps as in `shape_internal`, minus the ASCII fast path.
+            shape_begin(ctx);
+            prepare_text(ctx);
+            rotate_chars(ctx);
+
+            if stage != Stage::Normalize {
+                ot_shape_normalize::_hb_ot_shape_normalize(plan, ctx.buffer, face);
+                prepare_glyphs(ctx);
+                substitute_start(ctx);
+            }
+
+            if stage == Stage::Position || stage == Stage::Kern {
+                substitute_glyphs(ctx);
+                position_start(ctx);
+            }
+
+            if stage == Stage::Kern {
+                position_layout(plan, face, ctx.buffer);
+            }
+
+            StageInput { buffer, stage }
+        }
+
+        /// Runs the stage and returns the resulting number of glyphs.
+        pub fn run(&mut self, face: &hb_font_t, plan: &hb_ot_shape_plan_t) -> usize {
+            let buffer = &mut self.buffer;
+            match self.stage {
+                Stage::Normalize => ot_shape_normalize::_hb_ot_shape_normalize(plan, buffer, face),
+                Stage::Substitute => substitute_by_plan(plan, face, buffer),
+                Stage::Position => position_layout(plan, face, buffer),
+                Stage::Kern => position_kern(plan, face, buffer),
+            }
+            buffer.len
+        }
+    }
+}
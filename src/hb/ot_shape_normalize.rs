@@ -4,7 +4,7 @@ use super::hb_font_t;
 use super::ot_layout::*;
 use super::ot_shape_plan::hb_ot_shape_plan_t;
 use super::ot_shaper::{ComposeFn, DecomposeFn, MAX_COMBINING_MARKS};
-use super::unicode::{hb_unicode_funcs_t, CharExt};
+use super::unicode::{has_decomposition, hb_unicode_funcs_t, CharExt};
 
 pub struct hb_ot_shape_normalize_context_t<'a> {
     pub plan: &'a hb_ot_shape_plan_t,
@@ -265,6 +265,44 @@ fn decompose_multi_char_cluster(
     }
 }
 
+// Returns the end of the simple clusters starting at `start`, leaving one base
+// for the marks that follow to cluster with.
+fn simple_clusters_end(info: &[hb_glyph_info_t], start: usize) -> usize {
+    let count = info.len();
+    let mut end = start + 1;
+    while end < count && !_hb_glyph_info_is_unicode_mark(&info[end]) {
+        end += 1;
+    }
+
+    if end < count {
+        end -= 1;
+    }
+
+    end
+}
+
+// Quick check: sets the glyph indices of the leading characters of simple clusters
+// that all rounds leave as is, and returns their number.
+//
+// That is the characters the font has a nominal glyph for, which, unless we
+// short-circuit, also must not have a canonical decomposition.
+fn quick_check(info: &mut [hb_glyph_info_t], face: &hb_font_t, check_decomposition: bool) -> usize {
+    let mut done = 0;
+    for info in info {
+        if check_decomposition && has_decomposition(info.as_char()) {
+            break;
+        }
+
+        match face.get_nominal_glyph(info.glyph_id) {
+            Some(glyph_id) => info.set_glyph_index(u32::from(glyph_id.0)),
+            None => break,
+        }
+
+        done += 1;
+    }
+    done
+}
+
 fn compare_combining_class(pa: &hb_glyph_info_t, pb: &hb_glyph_info_t) -> bool {
     let a = _hb_glyph_info_get_modified_combining_class(pa);
     let b = _hb_glyph_info_get_modified_combining_class(pb);
@@ -313,39 +351,41 @@ pub fn _hb_ot_shape_normalize(
     // two rounds into the inner loop for the first round, but it's more readable
     // this way.
 
+    // The quick check only knows about the Unicode decompositions, so it can't
+    // tell which characters a shaper decomposes when we don't short-circuit.
+    let quick_check_decompositions = !might_short_circuit;
+    let use_quick_check = might_short_circuit || plan.shaper.decompose.is_none();
+
     // First round, decompose
     let mut all_simple = true;
-    {
+
+    // Text that is already normalized, with no marks and a glyph for every
+    // character, is mapped in place without going through the out-buffer.
+    let mut done = 0;
+    if use_quick_check {
+        let end = simple_clusters_end(&buffer.info[..buffer.len], 0);
+        done = quick_check(&mut buffer.info[..end], face, quick_check_decompositions);
+    }
+
+    if done < buffer.len {
         buffer.clear_output();
+        buffer.next_glyphs(done);
         let count = buffer.len;
-        buffer.idx = 0;
         loop {
-            let mut end = buffer.idx + 1;
-            while end < count && !_hb_glyph_info_is_unicode_mark(&buffer.info[end]) {
-                end += 1;
-            }
-
-            if end < count {
-                // Leave one base for the marks to cluster with.
-                end -= 1;
-            }
+            let end = simple_clusters_end(&buffer.info[..count], buffer.idx);
 
             // From idx to end are simple clusters.
-            if might_short_circuit {
-                let len = end - buffer.idx;
-                let mut done = 0;
-                while done < len {
-                    let cur = buffer.cur_mut(done);
-                    cur.set_glyph_index(match face.get_nominal_glyph(cur.glyph_id) {
-                        Some(glyph_id) => u32::from(glyph_id.0),
-                        None => break,
-                    });
-                    done += 1;
+            while buffer.idx < end && buffer.successful {
+                if use_quick_check {
+                    let idx = buffer.idx;
+                    let done =
+                        quick_check(&mut buffer.info[idx..end], face, quick_check_decompositions);
+                    buffer.next_glyphs(done);
+                    if buffer.idx == end || !buffer.successful {
+                        break;
+                    }
                 }
-                buffer.next_glyphs(done);
-            }
 
-            while buffer.idx < end && buffer.successful {
                 decompose_current_character(&mut ctx, might_short_circuit);
                 buffer = &mut ctx.buffer;
             }
@@ -357,7 +397,7 @@ pub fn _hb_ot_shape_normalize(
             all_simple = false;
 
             // Find all the marks now.
-            end = buffer.idx + 1;
+            let mut end = buffer.idx + 1;
             while end < count && _hb_glyph_info_is_unicode_mark(&buffer.info[end]) {
                 end += 1;
             }
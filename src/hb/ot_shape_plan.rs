@@ -1,11 +1,13 @@
 use alloc::boxed::Box;
+use alloc::sync::Arc;
 use alloc::vec::Vec;
 use core::any::Any;
 
+use super::ot_layout::TableIndex;
 use super::ot_map::*;
 use super::ot_shape::*;
 use super::ot_shaper::*;
-use super::{hb_font_t, hb_mask_t, Direction, Feature, Language, Script};
+use super::{hb_font_t, hb_mask_t, hb_tag_t, Direction, Feature, Language, Script};
 
 /// A reusable plan for shaping a text buffer.
 pub struct hb_ot_shape_plan_t {
@@ -37,6 +39,7 @@ pub struct hb_ot_shape_plan_t {
     pub(crate) apply_kerx: bool,
     pub(crate) apply_morx: bool,
     pub(crate) apply_trak: bool,
+    pub(crate) ascii_fast_path: bool,
 
     pub(crate) user_features: Vec<Feature>,
 }
@@ -57,11 +60,417 @@ impl hb_ot_shape_plan_t {
         planner.compile(user_features)
     }
 
+    /// Returns a plan for the provided properties, reusing a previously created
+    /// one from the face's plan cache when possible.
+    ///
+    /// This is the equivalent of `hb_shape_plan_create_cached`. The cache is keyed
+    /// on the direction, script, language, user features and the current variation
+    /// coordinates of `face`, and holds a limited number of plans. Without the `std`
+    /// feature no caching is performed and a new plan is created on every call.
+    pub fn new_cached(
+        face: &hb_font_t,
+        direction: Direction,
+        script: Option<Script>,
+        language: Option<&Language>,
+        user_features: &[Feature],
+    ) -> Arc<Self> {
+        face.face_data
+            .plan_cache
+            .get_or_create(face, direction, script, language, user_features)
+    }
+
+    /// Serializes the plan into a compact byte format, to be loaded back with
+    /// [`from_bytes`](Self::from_bytes) without compiling it again.
+    ///
+    /// The data is tied to the font tables and variation coordinates of `face`,
+    /// which must be the face the plan was created for, and to the version of this crate.
+    ///
+    /// Returns `None` if the plan can't be serialized.
+    pub fn to_bytes(&self, face: &hb_font_t) -> Option<Vec<u8>> {
+        let mut out = Vec::new();
+        out.extend_from_slice(PLAN_MAGIC);
+        out.push(PLAN_FORMAT_VERSION);
+        let version = env!("CARGO_PKG_VERSION").as_bytes();
+        out.push(version.len() as u8);
+        out.extend_from_slice(version);
+        out.extend_from_slice(&face_key(face).to_le_bytes());
+
+        out.push(match self.direction {
+            Direction::Invalid => return None,
+            Direction::LeftToRight => 0,
+            Direction::RightToLeft => 1,
+            Direction::TopToBottom => 2,
+            Direction::BottomToTop => 3,
+        });
+        out.extend_from_slice(&self.script.map_or(0, |s| s.tag().as_u32()).to_le_bytes());
+
+        self.ot_map.write(&mut out);
+
+        for mask in [
+            self.frac_mask,
+            self.numr_mask,
+            self.dnom_mask,
+            self.rtlm_mask,
+            self.kern_mask,
+            self.trak_mask,
+        ] {
+            out.extend_from_slice(&mask.to_le_bytes());
+        }
+
+        let flags = self
+            .flags()
+            .iter()
+            .enumerate()
+            .fold(0u16, |acc, (i, flag)| acc | (u16::from(*flag) << i));
+        out.extend_from_slice(&flags.to_le_bytes());
+
+        out.extend_from_slice(&(self.user_features.len() as u32).to_le_bytes());
+        for feature in &self.user_features {
+            out.extend_from_slice(&feature.tag.as_u32().to_le_bytes());
+            out.extend_from_slice(&feature.value.to_le_bytes());
+            out.extend_from_slice(&feature.start.to_le_bytes());
+            out.extend_from_slice(&feature.end.to_le_bytes());
+        }
+
+        Some(out)
+    }
+
+    /// Loads a plan serialized with [`to_bytes`](Self::to_bytes).
+    ///
+    /// Returns `None` if `data` is malformed, was written by a different version of
+    /// this crate, or for a face with different tables or variation coordinates.
+    pub fn from_bytes(face: &hb_font_t, data: &[u8]) -> Option<Self> {
+        let mut r = hb_plan_reader_t::new(data);
+        if r.bytes(PLAN_MAGIC.len())? != PLAN_MAGIC || r.u8()? != PLAN_FORMAT_VERSION {
+            return None;
+        }
+        let version_len = usize::from(r.u8()?);
+        if r.bytes(version_len)? != env!("CARGO_PKG_VERSION").as_bytes() {
+            return None;
+        }
+        if r.u64()? != face_key(face) {
+            return None;
+        }
+
+        let direction = match r.u8()? {
+            0 => Direction::LeftToRight,
+            1 => Direction::RightToLeft,
+            2 => Direction::TopToBottom,
+            3 => Direction::BottomToTop,
+            _ => return None,
+        };
+        let script = match r.u32()? {
+            0 => None,
+            tag => Some(Script(hb_tag_t(tag))),
+        };
+
+        let ot_map = hb_ot_map_t::read(&mut r)?;
+
+        let mut masks = [0; 6];
+        for mask in &mut masks {
+            *mask = r.u32()?;
+        }
+        let [frac_mask, numr_mask, dnom_mask, rtlm_mask, kern_mask, trak_mask] = masks;
+
+        let flags = r.u16()?;
+        let flag = |i: u32| flags & (1 << i) != 0;
+
+        let mut user_features = Vec::new();
+        for _ in 0..r.len(16)? {
+            user_features.push(Feature {
+                tag: hb_tag_t(r.u32()?),
+                value: r.u32()?,
+                start: r.u32()?,
+                end: r.u32()?,
+            });
+        }
+        if !r.is_empty() {
+            return None;
+        }
+
+        // The shaper is chosen the same way as by the planner.
+        let apply_morx = flag(14);
+        let mut shaper = match script {
+            Some(script) => hb_ot_shape_complex_categorize(
+                script,
+                direction,
+                ot_map.chosen_script(TableIndex::GSUB),
+            ),
+            None => &DEFAULT_SHAPER,
+        };
+        if apply_morx && shaper as *const _ != &DEFAULT_SHAPER as *const _ {
+            shaper = &DUMBER_SHAPER;
+        }
+
+        let mut plan = hb_ot_shape_plan_t {
+            direction,
+            script,
+            shaper,
+            ot_map,
+            data: None,
+            frac_mask,
+            numr_mask,
+            dnom_mask,
+            rtlm_mask,
+            kern_mask,
+            trak_mask,
+            requested_kerning: flag(0),
+            has_frac: flag(1),
+            has_vert: flag(2),
+            has_gpos_mark: flag(3),
+            zero_marks: flag(4),
+            fallback_glyph_classes: flag(5),
+            fallback_mark_positioning: flag(6),
+            adjust_mark_positioning_when_zeroing: flag(7),
+            apply_gpos: flag(8),
+            apply_fallback_kern: flag(9),
+            apply_kern: flag(10),
+            apply_kerx: flag(11),
+            apply_morx,
+            apply_trak: flag(12),
+            ascii_fast_path: flag(13),
+            user_features,
+        };
+
+        // Shaper data is derived from the map only, so it is cheap to recompute.
+        if let Some(func) = plan.shaper.create_data {
+            plan.data = Some(func(&plan));
+        }
+
+        Some(plan)
+    }
+
+    // Boolean fields in serialization order, see `from_bytes`.
+    fn flags(&self) -> [bool; 15] {
+        [
+            self.requested_kerning,
+            self.has_frac,
+            self.has_vert,
+            self.has_gpos_mark,
+            self.zero_marks,
+            self.fallback_glyph_classes,
+            self.fallback_mark_positioning,
+            self.adjust_mark_positioning_when_zeroing,
+            self.apply_gpos,
+            self.apply_fallback_kern,
+            self.apply_kern,
+            self.apply_kerx,
+            self.apply_trak,
+            self.ascii_fast_path,
+            self.apply_morx,
+        ]
+    }
+
     pub(crate) fn data<T: 'static>(&self) -> &T {
         self.data.as_ref().unwrap().downcast_ref().unwrap()
     }
 }
 
+const PLAN_MAGIC: &[u8; 4] = b"HRSP";
+const PLAN_FORMAT_VERSION: u8 = 1;
+
+// FNV-1a over the table records and variation coordinates of the face.
+fn face_key(face: &hb_font_t) -> u64 {
+    let mut hash = 0xcbf29ce484222325u64;
+    let mut write = |bytes: &[u8]| {
+        for byte in bytes {
+            hash = (hash ^ u64::from(*byte)).wrapping_mul(0x100000001b3);
+        }
+    };
+
+    for record in face.raw_face().table_records {
+        write(&record.tag.as_u32().to_le_bytes());
+        write(&record.check_sum.to_le_bytes());
+        write(&record.offset.to_le_bytes());
+        write(&record.length.to_le_bytes());
+    }
+    for coord in face.ttfp_face.variation_coordinates() {
+        write(&coord.get().to_le_bytes());
+    }
+
+    hash
+}
+
+/// A little-endian reader of serialized plans.
+pub(crate) struct hb_plan_reader_t<'a> {
+    data: &'a [u8],
+}
+
+impl<'a> hb_plan_reader_t<'a> {
+    fn new(data: &'a [u8]) -> Self {
+        hb_plan_reader_t { data }
+    }
+
+    fn is_empty(&self) -> bool {
+        self.data.is_empty()
+    }
+
+    fn bytes(&mut self, len: usize) -> Option<&'a [u8]> {
+        if len > self.data.len() {
+            return None;
+        }
+        let (bytes, rest) = self.data.split_at(len);
+        self.data = rest;
+        Some(bytes)
+    }
+
+    fn array<const N: usize>(&mut self) -> Option<[u8; N]> {
+        self.bytes(N)?.try_into().ok()
+    }
+
+    pub fn u8(&mut self) -> Option<u8> {
+        Some(self.array::<1>()?[0])
+    }
+
+    pub fn bool(&mut self) -> Option<bool> {
+        match self.u8()? {
+            0 => Some(false),
+            1 => Some(true),
+            _ => None,
+        }
+    }
+
+    pub fn u16(&mut self) -> Option<u16> {
+        self.array().map(u16::from_le_bytes)
+    }
+
+    pub fn u32(&mut self) -> Option<u32> {
+        self.array().map(u32::from_le_bytes)
+    }
+
+    pub fn u64(&mut self) -> Option<u64> {
+        self.array().map(u64::from_le_bytes)
+    }
+
+    /// Reads an item count, checking that the data has room for that many items
+    /// of at least `item_size` bytes, so that no huge allocation is made.
+    pub fn len(&mut self, item_size: usize) -> Option<usize> {
+        let len = self.u32()? as usize;
+        (len.checked_mul(item_size)? <= self.data.len()).then_some(len)
+    }
+}
+
+// Maximum number of plans kept alive by a single face.
+#[cfg(feature = "std")]
+const HB_SHAPE_PLAN_CACHE_MAX_LEN: usize = 32;
+
+#[cfg(feature = "std")]
+struct hb_shape_plan_key_t {
+    direction: Direction,
+    script: Option<Script>,
+    language: Option<Language>,
+    user_features: Vec<Feature>,
+    coords: Vec<i16>,
+}
+
+#[cfg(feature = "std")]
+impl hb_shape_plan_key_t {
+    fn equal(
+        &self,
+        direction: Direction,
+        script: Option<Script>,
+        language: Option<&Language>,
+        user_features: &[Feature],
+        coords: &[ttf_parser::NormalizedCoordinate],
+    ) -> bool {
+        self.direction == direction
+            && self.script == script
+            && self.language.as_ref() == language
+            && self.user_features.as_slice() == user_features
+            && self.coords.len() == coords.len()
+            && self.coords.iter().zip(coords).all(|(a, b)| *a == b.get())
+    }
+}
+
+/// A bounded, thread-safe cache of shape plans for a single face.
+///
+/// Plans are kept in most-recently-used order; the least recently used plan
+/// is dropped once the cache is full.
+#[derive(Default)]
+pub(crate) struct hb_shape_plan_cache_t {
+    #[cfg(feature = "std")]
+    plans: std::sync::Mutex<Vec<(hb_shape_plan_key_t, Arc<hb_ot_shape_plan_t>)>>,
+}
+
+impl hb_shape_plan_cache_t {
+    #[cfg(feature = "std")]
+    fn get_or_create(
+        &self,
+        face: &hb_font_t,
+        direction: Direction,
+        script: Option<Script>,
+        language: Option<&Language>,
+        user_features: &[Feature],
+    ) -> Arc<hb_ot_shape_plan_t> {
+        let coords = face.ttfp_face.variation_coordinates();
+
+        {
+            let mut plans = self.plans.lock().unwrap_or_else(|e| e.into_inner());
+            let found = plans
+                .iter()
+                .position(|(key, _)| key.equal(direction, script, language, user_features, coords));
+            if let Some(idx) = found {
+                plans[..=idx].rotate_right(1);
+                return plans[0].1.clone();
+            }
+        }
+
+        // Plan compilation is slow, don't hold the lock while doing it.
+        let plan = Arc::new(hb_ot_shape_plan_t::new(
+            face,
+            direction,
+            script,
+            language,
+            user_features,
+        ));
+
+        let mut plans = self.plans.lock().unwrap_or_else(|e| e.into_inner());
+        // Another thread might have created the same plan in the meantime.
+        if let Some(idx) = plans
+            .iter()
+            .position(|(key, _)| key.equal(direction, script, language, user_features, coords))
+        {
+            plans[..=idx].rotate_right(1);
+            return plans[0].1.clone();
+        }
+
+        plans.truncate(HB_SHAPE_PLAN_CACHE_MAX_LEN - 1);
+        plans.insert(
+            0,
+            (
+                hb_shape_plan_key_t {
+                    direction,
+                    script,
+                    language: language.cloned(),
+                    user_features: user_features.to_vec(),
+                    coords: coords.iter().map(|c| c.get()).collect(),
+                },
+                plan.clone(),
+            ),
+        );
+
+        plan
+    }
+
+    #[cfg(not(feature = "std"))]
+    fn get_or_create(
+        &self,
+        face: &hb_font_t,
+        direction: Direction,
+        script: Option<Script>,
+        language: Option<&Language>,
+        user_features: &[Feature],
+    ) -> Arc<hb_ot_shape_plan_t> {
+        Arc::new(hb_ot_shape_plan_t::new(
+            face,
+            direction,
+            script,
+            language,
+            user_features,
+        ))
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::hb_ot_shape_plan_t;
@@ -71,4 +480,10 @@ mod tests {
         fn ensure_send_and_sync<T: Send + Sync>() {}
         ensure_send_and_sync::<hb_ot_shape_plan_t>();
     }
+
+    #[test]
+    fn test_shape_plan_cache_is_send_and_sync() {
+        fn ensure_send_and_sync<T: Send + Sync>() {}
+        ensure_send_and_sync::<super::hb_shape_plan_cache_t>();
+    }
 }
@@ -205,7 +205,9 @@ fn collect_features(planner: &mut hb_ot_shape_planner_t) {
     planner
         .ot_map
         .enable_feature(hb_tag_t::from_bytes(b"stch"), F_NONE, 1);
-    planner.ot_map.add_gsub_pause(Some(record_stch));
+    planner
+        .ot_map
+        .add_gsub_pause(Some(pause_t::ArabicRecordStch));
 
     planner
         .ot_map
@@ -236,7 +238,9 @@ fn collect_features(planner: &mut hb_ot_shape_planner_t) {
     );
 
     if planner.script == Some(script::ARABIC) {
-        planner.ot_map.add_gsub_pause(Some(arabic_fallback_shape));
+        planner
+            .ot_map
+            .add_gsub_pause(Some(pause_t::ArabicFallbackShape));
     }
 
     // No pause after rclt.
@@ -406,7 +410,7 @@ pub fn setup_masks_inner(
     }
 }
 
-fn arabic_fallback_shape(_: &hb_ot_shape_plan_t, _: &hb_font_t, _: &mut hb_buffer_t) -> bool {
+pub fn arabic_fallback_shape(_: &hb_ot_shape_plan_t, _: &hb_font_t, _: &mut hb_buffer_t) -> bool {
     false
 }
 
@@ -415,7 +419,7 @@ fn arabic_fallback_shape(_: &hb_ot_shape_plan_t, _: &hb_font_t, _: &mut hb_buffe
 // https://docs.microsoft.com/en-us/typography/script-development/syriac
 // We implement this in a generic way, such that the Arabic subtending
 // marks can use it as well.
-fn record_stch(plan: &hb_ot_shape_plan_t, _: &hb_font_t, buffer: &mut hb_buffer_t) -> bool {
+pub fn record_stch(plan: &hb_ot_shape_plan_t, _: &hb_font_t, buffer: &mut hb_buffer_t) -> bool {
     let arabic_plan = plan.data::<arabic_shape_plan_t>();
     if !arabic_plan.has_stch {
         return false;
@@ -422,6 +422,7 @@ impl IndicWouldSubstituteFeature {
                 zero_context: self.zero_context,
             };
             if face
+                .face_data
                 .gsub
                 .as_ref()
                 .and_then(|table| table.get_lookup(lookup.index))
@@ -596,7 +597,9 @@ impl hb_glyph_info_t {
 
 fn collect_features(planner: &mut hb_ot_shape_planner_t) {
     // Do this before any lookups have been applied.
-    planner.ot_map.add_gsub_pause(Some(setup_syllables));
+    planner
+        .ot_map
+        .add_gsub_pause(Some(pause_t::IndicSetupSyllables));
 
     planner
         .ot_map
@@ -607,14 +610,18 @@ fn collect_features(planner: &mut hb_ot_shape_planner_t) {
         .ot_map
         .enable_feature(hb_tag_t::from_bytes(b"ccmp"), F_PER_SYLLABLE, 1);
 
-    planner.ot_map.add_gsub_pause(Some(initial_reordering));
+    planner
+        .ot_map
+        .add_gsub_pause(Some(pause_t::IndicInitialReordering));
 
     for feature in INDIC_FEATURES.iter().take(11) {
         planner.ot_map.add_feature(feature.0, feature.1, 1);
         planner.ot_map.add_gsub_pause(None);
     }
 
-    planner.ot_map.add_gsub_pause(Some(final_reordering));
+    planner
+        .ot_map
+        .add_gsub_pause(Some(pause_t::IndicFinalReordering));
 
     for feature in INDIC_FEATURES.iter().skip(11) {
         planner.ot_map.add_feature(feature.0, feature.1, 1);
@@ -625,7 +632,9 @@ fn override_features(planner: &mut hb_ot_shape_planner_t) {
     planner
         .ot_map
         .disable_feature(hb_tag_t::from_bytes(b"liga"));
-    planner.ot_map.add_gsub_pause(Some(syllabic_clear_var)); // Don't need syllables anymore.
+    planner
+        .ot_map
+        .add_gsub_pause(Some(pause_t::SyllabicClearVar)); // Don't need syllables anymore.
 }
 
 fn preprocess_text(_: &hb_ot_shape_plan_t, _: &hb_font_t, buffer: &mut hb_buffer_t) {
@@ -668,7 +677,7 @@ fn setup_masks(_: &hb_ot_shape_plan_t, _: &hb_font_t, buffer: &mut hb_buffer_t)
     }
 }
 
-fn setup_syllables(_: &hb_ot_shape_plan_t, _: &hb_font_t, buffer: &mut hb_buffer_t) -> bool {
+pub fn setup_syllables(_: &hb_ot_shape_plan_t, _: &hb_font_t, buffer: &mut hb_buffer_t) -> bool {
     super::ot_shaper_indic_machine::find_syllables_indic(buffer);
 
     let mut start = 0;
@@ -682,7 +691,7 @@ fn setup_syllables(_: &hb_ot_shape_plan_t, _: &hb_font_t, buffer: &mut hb_buffer
     false
 }
 
-fn initial_reordering(
+pub fn initial_reordering(
     plan: &hb_ot_shape_plan_t,
     face: &hb_font_t,
     buffer: &mut hb_buffer_t,
@@ -1368,7 +1377,11 @@ fn initial_reordering_standalone_cluster(
     initial_reordering_consonant_syllable(plan, indic_plan, face, start, end, buffer);
 }
 
-fn final_reordering(plan: &hb_ot_shape_plan_t, face: &hb_font_t, buffer: &mut hb_buffer_t) -> bool {
+pub fn final_reordering(
+    plan: &hb_ot_shape_plan_t,
+    face: &hb_font_t,
+    buffer: &mut hb_buffer_t,
+) -> bool {
     if buffer.is_empty() {
         return false;
     }
@@ -13,6 +13,8 @@
 )]
 
 use super::buffer::{hb_buffer_t, HB_BUFFER_SCRATCH_FLAG_HAS_BROKEN_SYLLABLE};
+use super::fonta::once_cell::OnceCell;
+use super::ot_shaper_syllabic::hb_syllable_dfa_t;
 
 static _indic_syllable_machine_actions: [i8; 44] = [
     0, 1, 0, 1, 1, 1, 2, 1, 6, 1, 7, 1, 8, 1, 9, 1, 10, 1, 11, 1, 12, 1, 13, 1, 14, 1, 15, 1, 16,
@@ -202,6 +204,27 @@ pub enum SyllableType {
     NonIndicCluster,
 }
 
+fn syllable_dfa() -> &'static hb_syllable_dfa_t {
+    static DFA: OnceCell<hb_syllable_dfa_t> = OnceCell::new();
+    DFA.get_or_init(|| {
+        hb_syllable_dfa_t::new(
+            &_indic_syllable_machine_key_offsets,
+            &_indic_syllable_machine_trans_keys,
+            &_indic_syllable_machine_single_lengths,
+            &_indic_syllable_machine_range_lengths,
+            &_indic_syllable_machine_index_offsets,
+            &_indic_syllable_machine_cond_targs,
+            |state, trans| {
+                _indic_syllable_machine_from_state_actions[state] == 0
+                    && _indic_syllable_machine_cond_actions[trans] == 0
+                    && _indic_syllable_machine_to_state_actions
+                        [_indic_syllable_machine_cond_targs[trans] as usize]
+                        == 0
+            },
+        )
+    })
+}
+
 pub fn find_syllables_indic(buffer: &mut hb_buffer_t) {
     let mut cs = 0;
     let mut ts = 0;
@@ -226,13 +249,15 @@ pub fn find_syllables_indic(buffer: &mut hb_buffer_t) {
     }
 
     {
-        let mut _klen = 0;
         let mut _trans = 0;
-        let mut _keys: i32 = 0;
         let mut _acts: i32 = 0;
         let mut _nacts = 0;
-        let mut __have = 0;
+        let dfa = syllable_dfa();
         '_resume: while (p != pe || p == eof) {
+            // Transitions without actions are taken in a tight loop.
+            while p != pe && dfa.step_quiet(&mut cs, buffer.info[p].indic_category() as u8) {
+                p += 1;
+            }
             '_again: while (true) {
                 _acts = (_indic_syllable_machine_from_state_actions[(cs) as usize]) as i32;
                 _nacts = (_indic_syllable_machine_actions[(_acts) as usize]) as u32;
@@ -259,73 +284,7 @@ pub fn find_syllables_indic(buffer: &mut hb_buffer_t) {
                     }
                 } else {
                     {
-                        _keys = (_indic_syllable_machine_key_offsets[(cs) as usize]) as i32;
-                        _trans = (_indic_syllable_machine_index_offsets[(cs) as usize]) as u32;
-                        _klen = (_indic_syllable_machine_single_lengths[(cs) as usize]) as i32;
-                        __have = 0;
-                        if (_klen > 0) {
-                            {
-                                let mut _lower: i32 = _keys;
-                                let mut _upper: i32 = _keys + _klen - 1;
-                                let mut _mid: i32 = 0;
-                                while (true) {
-                                    if (_upper < _lower) {
-                                        {
-                                            _keys += _klen;
-                                            _trans += (_klen) as u32;
-                                            break;
-                                        }
-                                    }
-                                    _mid = _lower + ((_upper - _lower) >> 1);
-                                    if ((buffer.info[p].indic_category() as u8)
-                                        < _indic_syllable_machine_trans_keys[(_mid) as usize])
-                                    {
-                                        _upper = _mid - 1;
-                                    } else if ((buffer.info[p].indic_category() as u8)
-                                        > _indic_syllable_machine_trans_keys[(_mid) as usize])
-                                    {
-                                        _lower = _mid + 1;
-                                    } else {
-                                        {
-                                            __have = 1;
-                                            _trans += (_mid - _keys) as u32;
-                                            break;
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                        _klen = (_indic_syllable_machine_range_lengths[(cs) as usize]) as i32;
-                        if (__have == 0 && _klen > 0) {
-                            {
-                                let mut _lower: i32 = _keys;
-                                let mut _upper: i32 = _keys + (_klen << 1) - 2;
-                                let mut _mid: i32 = 0;
-                                while (true) {
-                                    if (_upper < _lower) {
-                                        {
-                                            _trans += (_klen) as u32;
-                                            break;
-                                        }
-                                    }
-                                    _mid = _lower + (((_upper - _lower) >> 1) & !1);
-                                    if ((buffer.info[p].indic_category() as u8)
-                                        < _indic_syllable_machine_trans_keys[(_mid) as usize])
-                                    {
-                                        _upper = _mid - 2;
-                                    } else if ((buffer.info[p].indic_category() as u8)
-                                        > _indic_syllable_machine_trans_keys[(_mid + 1) as usize])
-                                    {
-                                        _lower = _mid + 2;
-                                    } else {
-                                        {
-                                            _trans += ((_mid - _keys) >> 1) as u32;
-                                            break;
-                                        }
-                                    }
-                                }
-                            }
-                        }
+                        _trans = dfa.trans(cs, buffer.info[p].indic_category() as u8);
                     }
                 }
                 cs = (_indic_syllable_machine_cond_targs[(_trans) as usize]) as i32;
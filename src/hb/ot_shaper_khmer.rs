@@ -97,8 +97,10 @@ impl KhmerShapePlan {
 
 fn collect_features(planner: &mut hb_ot_shape_planner_t) {
     // Do this before any lookups have been applied.
-    planner.ot_map.add_gsub_pause(Some(setup_syllables));
-    planner.ot_map.add_gsub_pause(Some(reorder_khmer));
+    planner
+        .ot_map
+        .add_gsub_pause(Some(pause_t::KhmerSetupSyllables));
+    planner.ot_map.add_gsub_pause(Some(pause_t::KhmerReorder));
 
     // Testing suggests that Uniscribe does NOT pause between basic
     // features.  Test with KhmerUI.ttf and the following three
@@ -121,14 +123,16 @@ fn collect_features(planner: &mut hb_ot_shape_planner_t) {
     }
 
     /* https://github.com/harfbuzz/harfbuzz/issues/3531 */
-    planner.ot_map.add_gsub_pause(Some(syllabic_clear_var)); // Don't need syllables anymore.
+    planner
+        .ot_map
+        .add_gsub_pause(Some(pause_t::SyllabicClearVar)); // Don't need syllables anymore.
 
     for feature in KHMER_FEATURES.iter().skip(5) {
         planner.ot_map.add_feature(feature.0, feature.1, 1);
     }
 }
 
-fn setup_syllables(_: &hb_ot_shape_plan_t, _: &hb_font_t, buffer: &mut hb_buffer_t) -> bool {
+pub fn setup_syllables(_: &hb_ot_shape_plan_t, _: &hb_font_t, buffer: &mut hb_buffer_t) -> bool {
     super::ot_shaper_khmer_machine::find_syllables_khmer(buffer);
 
     let mut start = 0;
@@ -142,7 +146,11 @@ fn setup_syllables(_: &hb_ot_shape_plan_t, _: &hb_font_t, buffer: &mut hb_buffer
     false
 }
 
-fn reorder_khmer(plan: &hb_ot_shape_plan_t, face: &hb_font_t, buffer: &mut hb_buffer_t) -> bool {
+pub fn reorder_khmer(
+    plan: &hb_ot_shape_plan_t,
+    face: &hb_font_t,
+    buffer: &mut hb_buffer_t,
+) -> bool {
     use super::ot_shaper_khmer_machine::SyllableType;
 
     let mut ret = false;
@@ -14,6 +14,8 @@
 )]
 
 use super::buffer::{HB_BUFFER_SCRATCH_FLAG_HAS_BROKEN_SYLLABLE, hb_buffer_t};
+use super::fonta::once_cell::OnceCell;
+use super::ot_shaper_syllabic::hb_syllable_dfa_t;
 
 %%{
   machine khmer_syllable_machine;
@@ -77,6 +79,27 @@ pub enum SyllableType {
     NonKhmerCluster,
 }
 
+fn syllable_dfa() -> &'static hb_syllable_dfa_t {
+    static DFA: OnceCell<hb_syllable_dfa_t> = OnceCell::new();
+    DFA.get_or_init(|| {
+        hb_syllable_dfa_t::new(
+            &_khmer_syllable_machine_key_offsets,
+            &_khmer_syllable_machine_trans_keys,
+            &_khmer_syllable_machine_single_lengths,
+            &_khmer_syllable_machine_range_lengths,
+            &_khmer_syllable_machine_index_offsets,
+            &_khmer_syllable_machine_cond_targs,
+            |state, trans| {
+                _khmer_syllable_machine_from_state_actions[state] == 0
+                    && _khmer_syllable_machine_cond_actions[trans] == 0
+                    && _khmer_syllable_machine_to_state_actions
+                        [_khmer_syllable_machine_cond_targs[trans] as usize]
+                        == 0
+            },
+        )
+    })
+}
+
 pub fn find_syllables_khmer(buffer: &mut hb_buffer_t) {
     let mut cs = 0;
     let mut ts = 0;
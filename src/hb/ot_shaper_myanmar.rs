@@ -70,7 +70,9 @@ impl hb_glyph_info_t {
 
 fn collect_features(planner: &mut hb_ot_shape_planner_t) {
     // Do this before any lookups have been applied.
-    planner.ot_map.add_gsub_pause(Some(setup_syllables));
+    planner
+        .ot_map
+        .add_gsub_pause(Some(pause_t::MyanmarSetupSyllables));
 
     planner
         .ot_map
@@ -81,7 +83,7 @@ fn collect_features(planner: &mut hb_ot_shape_planner_t) {
         .ot_map
         .enable_feature(hb_tag_t::from_bytes(b"ccmp"), F_PER_SYLLABLE, 1);
 
-    planner.ot_map.add_gsub_pause(Some(reorder_myanmar));
+    planner.ot_map.add_gsub_pause(Some(pause_t::MyanmarReorder));
 
     for feature in MYANMAR_FEATURES.iter().take(4) {
         planner
@@ -90,14 +92,16 @@ fn collect_features(planner: &mut hb_ot_shape_planner_t) {
         planner.ot_map.add_gsub_pause(None);
     }
 
-    planner.ot_map.add_gsub_pause(Some(syllabic_clear_var)); // Don't need syllables anymore.
+    planner
+        .ot_map
+        .add_gsub_pause(Some(pause_t::SyllabicClearVar)); // Don't need syllables anymore.
 
     for feature in MYANMAR_FEATURES.iter().skip(4) {
         planner.ot_map.enable_feature(*feature, F_MANUAL_ZWJ, 1);
     }
 }
 
-fn setup_syllables(_: &hb_ot_shape_plan_t, _: &hb_font_t, buffer: &mut hb_buffer_t) -> bool {
+pub fn setup_syllables(_: &hb_ot_shape_plan_t, _: &hb_font_t, buffer: &mut hb_buffer_t) -> bool {
     super::ot_shaper_myanmar_machine::find_syllables_myanmar(buffer);
 
     let mut start = 0;
@@ -111,7 +115,7 @@ fn setup_syllables(_: &hb_ot_shape_plan_t, _: &hb_font_t, buffer: &mut hb_buffer
     false
 }
 
-fn reorder_myanmar(_: &hb_ot_shape_plan_t, face: &hb_font_t, buffer: &mut hb_buffer_t) -> bool {
+pub fn reorder_myanmar(_: &hb_ot_shape_plan_t, face: &hb_font_t, buffer: &mut hb_buffer_t) -> bool {
     use super::ot_shaper_myanmar_machine::SyllableType;
 
     let mut ret = false;
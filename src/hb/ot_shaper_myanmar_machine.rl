@@ -14,6 +14,8 @@
 )]
 
 use super::buffer::{HB_BUFFER_SCRATCH_FLAG_HAS_BROKEN_SYLLABLE, hb_buffer_t};
+use super::fonta::once_cell::OnceCell;
+use super::ot_shaper_syllabic::hb_syllable_dfa_t;
 
 %%{
   machine myanmar_syllable_machine;
@@ -90,6 +92,27 @@ pub enum SyllableType {
     NonMyanmarCluster,
 }
 
+fn syllable_dfa() -> &'static hb_syllable_dfa_t {
+    static DFA: OnceCell<hb_syllable_dfa_t> = OnceCell::new();
+    DFA.get_or_init(|| {
+        hb_syllable_dfa_t::new(
+            &_myanmar_syllable_machine_key_offsets,
+            &_myanmar_syllable_machine_trans_keys,
+            &_myanmar_syllable_machine_single_lengths,
+            &_myanmar_syllable_machine_range_lengths,
+            &_myanmar_syllable_machine_index_offsets,
+            &_myanmar_syllable_machine_cond_targs,
+            |state, trans| {
+                _myanmar_syllable_machine_from_state_actions[state] == 0
+                    && _myanmar_syllable_machine_cond_actions[trans] == 0
+                    && _myanmar_syllable_machine_to_state_actions
+                        [_myanmar_syllable_machine_cond_targs[trans] as usize]
+                        == 0
+            },
+        )
+    })
+}
+
 pub fn find_syllables_myanmar(buffer: &mut hb_buffer_t) {
     let mut cs = 0;
     let mut ts = 0;
@@ -1,3 +1,6 @@
+use alloc::boxed::Box;
+use alloc::vec::Vec;
+
 use super::buffer::{hb_buffer_t, HB_BUFFER_SCRATCH_FLAG_HAS_BROKEN_SYLLABLE};
 use super::{hb_font_t, hb_glyph_info_t};
 use crate::BufferFlags;
@@ -70,3 +73,99 @@ pub fn insert_dotted_circles(
 
     true
 }
+
+/// Dense transitions of a ragel syllable machine, indexed by state and category.
+///
+/// ragel emits per-state lists of keys and key ranges that are binary searched for
+/// every glyph. These are resolved once for every category when the machine is first
+/// used, so finding syllables makes a single table load per glyph. Transitions that
+/// run no actions are marked, so that runs of them can be taken in a tight loop.
+pub struct hb_syllable_dfa_t {
+    // Categories past the largest key share the last column, the default transition.
+    width: usize,
+    // The transition index in the low half, the target state in the high half.
+    entries: Box<[u32]>,
+}
+
+// Marks entries of transitions without actions, see `step_quiet`.
+const DFA_QUIET: u32 = 1 << 31;
+
+impl hb_syllable_dfa_t {
+    /// Builds the table from the searched tables of a ragel machine.
+    ///
+    /// `is_quiet(state, trans)` tells whether taking `trans` from `state` runs no
+    /// from-state, transition or to-state actions.
+    pub fn new<T: Copy + Into<i32>>(
+        key_offsets: &[i16],
+        trans_keys: &[u8],
+        single_lengths: &[i8],
+        range_lengths: &[i8],
+        index_offsets: &[i16],
+        cond_targs: &[T],
+        is_quiet: impl Fn(usize, usize) -> bool,
+    ) -> Self {
+        let width = usize::from(trans_keys.iter().copied().max().unwrap_or(0)) + 2;
+        let states = index_offsets.len();
+        let mut entries = Vec::with_capacity(states * width);
+        for state in 0..states {
+            let keys = key_offsets[state] as usize;
+            let singles = single_lengths[state] as usize;
+            let ranges = range_lengths[state] as usize;
+            let singles_keys = &trans_keys[keys..keys + singles];
+            let range_keys = &trans_keys[keys + singles..keys + singles + 2 * ranges];
+            let first = index_offsets[state] as usize;
+
+            for category in 0..width {
+                let category = category as u8;
+                // Same precedence as the ragel search: single keys, then ranges, then the default.
+                let trans = if let Some(i) = singles_keys.iter().position(|&k| k == category) {
+                    first + i
+                } else if let Some(i) = range_keys
+                    .chunks_exact(2)
+                    .position(|range| range[0] <= category && category <= range[1])
+                {
+                    first + singles + i
+                } else {
+                    first + singles + ranges
+                };
+
+                let target = cond_targs[trans].into() as u32;
+                let mut entry = trans as u32 | (target << 16);
+                if is_quiet(state, trans) {
+                    entry |= DFA_QUIET;
+                }
+                entries.push(entry);
+            }
+        }
+
+        hb_syllable_dfa_t {
+            width,
+            entries: entries.into_boxed_slice(),
+        }
+    }
+
+    #[inline(always)]
+    fn entry(&self, state: i32, category: u8) -> u32 {
+        self.entries[state as usize * self.width + usize::from(category).min(self.width - 1)]
+    }
+
+    /// Returns the transition taken from `state` on `category`.
+    #[inline(always)]
+    pub fn trans(&self, state: i32, category: u8) -> u32 {
+        self.entry(state, category) & 0xFFFF
+    }
+
+    /// Takes the transition from `state` on `category` if it runs no actions.
+    ///
+    /// Returns `false` and leaves `state` unchanged otherwise.
+    #[inline(always)]
+    pub fn step_quiet(&self, state: &mut i32, category: u8) -> bool {
+        let entry = self.entry(*state, category);
+        if entry & DFA_QUIET == 0 {
+            return false;
+        }
+
+        *state = ((entry >> 16) & 0x7FFF) as i32;
+        true
+    }
+}
@@ -179,7 +179,9 @@ impl UniversalShapePlan {
 
 fn collect_features(planner: &mut hb_ot_shape_planner_t) {
     // Do this before any lookups have been applied.
-    planner.ot_map.add_gsub_pause(Some(setup_syllables));
+    planner
+        .ot_map
+        .add_gsub_pause(Some(pause_t::UseSetupSyllables));
 
     // Default glyph pre-processing group
     planner
@@ -200,22 +202,22 @@ fn collect_features(planner: &mut hb_ot_shape_planner_t) {
     // Reordering group
     planner
         .ot_map
-        .add_gsub_pause(Some(crate::hb::ot_layout::_hb_clear_substitution_flags));
+        .add_gsub_pause(Some(pause_t::ClearSubstitutionFlags));
     planner.ot_map.add_feature(
         hb_tag_t::from_bytes(b"rphf"),
         F_MANUAL_ZWJ | F_PER_SYLLABLE,
         1,
     );
-    planner.ot_map.add_gsub_pause(Some(record_rphf));
+    planner.ot_map.add_gsub_pause(Some(pause_t::UseRecordRphf));
     planner
         .ot_map
-        .add_gsub_pause(Some(crate::hb::ot_layout::_hb_clear_substitution_flags));
+        .add_gsub_pause(Some(pause_t::ClearSubstitutionFlags));
     planner.ot_map.enable_feature(
         hb_tag_t::from_bytes(b"pref"),
         F_MANUAL_ZWJ | F_PER_SYLLABLE,
         1,
     );
-    planner.ot_map.add_gsub_pause(Some(record_pref));
+    planner.ot_map.add_gsub_pause(Some(pause_t::UseRecordPref));
 
     // Orthographic unit shaping group
     for feature in BASIC_FEATURES {
@@ -224,8 +226,10 @@ fn collect_features(planner: &mut hb_ot_shape_planner_t) {
             .enable_feature(*feature, F_MANUAL_ZWJ | F_PER_SYLLABLE, 1);
     }
 
-    planner.ot_map.add_gsub_pause(Some(reorder_use));
-    planner.ot_map.add_gsub_pause(Some(syllabic_clear_var)); // Don't need syllables anymore.
+    planner.ot_map.add_gsub_pause(Some(pause_t::UseReorder));
+    planner
+        .ot_map
+        .add_gsub_pause(Some(pause_t::SyllabicClearVar)); // Don't need syllables anymore.
 
     // Topographical features
     for feature in TOPOGRAPHICAL_FEATURES {
@@ -239,7 +243,7 @@ fn collect_features(planner: &mut hb_ot_shape_planner_t) {
     }
 }
 
-fn setup_syllables(plan: &hb_ot_shape_plan_t, _: &hb_font_t, buffer: &mut hb_buffer_t) -> bool {
+pub fn setup_syllables(plan: &hb_ot_shape_plan_t, _: &hb_font_t, buffer: &mut hb_buffer_t) -> bool {
     super::ot_shaper_use_machine::find_syllables(buffer);
 
     foreach_syllable!(buffer, start, end, {
@@ -350,7 +354,7 @@ fn setup_topographical_masks(plan: &hb_ot_shape_plan_t, buffer: &mut hb_buffer_t
     }
 }
 
-fn record_rphf(plan: &hb_ot_shape_plan_t, _: &hb_font_t, buffer: &mut hb_buffer_t) -> bool {
+pub fn record_rphf(plan: &hb_ot_shape_plan_t, _: &hb_font_t, buffer: &mut hb_buffer_t) -> bool {
     let universal_plan = plan.data::<UniversalShapePlan>();
 
     let mask = universal_plan.rphf_mask;
@@ -380,7 +384,7 @@ fn record_rphf(plan: &hb_ot_shape_plan_t, _: &hb_font_t, buffer: &mut hb_buffer_
     false
 }
 
-fn reorder_use(_: &hb_ot_shape_plan_t, face: &hb_font_t, buffer: &mut hb_buffer_t) -> bool {
+pub fn reorder_use(_: &hb_ot_shape_plan_t, face: &hb_font_t, buffer: &mut hb_buffer_t) -> bool {
     use super::ot_shaper_use_machine::SyllableType;
 
     let mut ret = false;
@@ -502,7 +506,7 @@ fn reorder_syllable_use(start: usize, end: usize, buffer: &mut hb_buffer_t) {
     }
 }
 
-fn record_pref(_: &hb_ot_shape_plan_t, _: &hb_font_t, buffer: &mut hb_buffer_t) -> bool {
+pub fn record_pref(_: &hb_ot_shape_plan_t, _: &hb_font_t, buffer: &mut hb_buffer_t) -> bool {
     let mut start = 0;
     let mut end = buffer.next_syllable(0);
     while start < buffer.len {
@@ -16,9 +16,11 @@
 use core::cell::Cell;
 
 use super::buffer::{hb_buffer_t, HB_BUFFER_SCRATCH_FLAG_HAS_BROKEN_SYLLABLE};
+use super::fonta::once_cell::OnceCell;
 use super::hb_glyph_info_t;
 use super::machine_cursor::MachineCursor;
 use super::ot_layout::*;
+use super::ot_shaper_syllabic::hb_syllable_dfa_t;
 use super::ot_shaper_use::category;
 
 %%{
@@ -166,6 +168,27 @@ pub enum SyllableType {
     NonCluster,
 }
 
+fn syllable_dfa() -> &'static hb_syllable_dfa_t {
+    static DFA: OnceCell<hb_syllable_dfa_t> = OnceCell::new();
+    DFA.get_or_init(|| {
+        hb_syllable_dfa_t::new(
+            &_use_syllable_machine_key_offsets,
+            &_use_syllable_machine_trans_keys,
+            &_use_syllable_machine_single_lengths,
+            &_use_syllable_machine_range_lengths,
+            &_use_syllable_machine_index_offsets,
+            &_use_syllable_machine_cond_targs,
+            |state, trans| {
+                _use_syllable_machine_from_state_actions[state] == 0
+                    && _use_syllable_machine_cond_actions[trans] == 0
+                    && _use_syllable_machine_to_state_actions
+                        [_use_syllable_machine_cond_targs[trans] as usize]
+                        == 0
+            },
+        )
+    })
+}
+
 pub fn find_syllables(buffer: &mut hb_buffer_t) {
     let mut cs = 0;
     let infos = Cell::as_slice_of_cells(Cell::from_mut(&mut buffer.info));
@@ -17,7 +17,7 @@ pub trait hb_set_digest_ext: Clone + Default {
     fn may_have_glyph(&self, g: GlyphId) -> bool;
 }
 
-#[derive(Clone, Default, Debug)]
+#[derive(Clone, Default, Debug, PartialEq, Eq)]
 pub struct hb_set_digest_bits_pattern_t<const shift: u8> {
     mask: mask_t,
 }
@@ -112,7 +112,7 @@ impl<const shift: u8> hb_set_digest_ext for hb_set_digest_bits_pattern_t<shift>
     }
 }
 
-#[derive(Clone, Default, Debug)]
+#[derive(Clone, Default, Debug, PartialEq, Eq)]
 pub struct hb_set_digest_combiner_t<head_t, tail_t>
 where
     head_t: hb_set_digest_ext,
@@ -149,9 +149,10 @@ where
     }
 
     fn add_array(&mut self, array: impl IntoIterator<Item = GlyphId> + Clone) {
-        // TODO: Is this expensive if someone passes e.g. a vector?
-        self.head.add_array(array.clone());
-        self.tail.add_array(array);
+        // A single pass, instead of one per pattern.
+        for g in array {
+            self.add(g);
+        }
     }
 
     fn add_range(&mut self, a: GlyphId, b: GlyphId) -> bool {
@@ -178,6 +179,49 @@ pub type hb_set_digest_t = hb_set_digest_combiner_t<
     >,
 >;
 
+impl hb_set_digest_t {
+    /// Creates a digest of the glyphs of `items`.
+    ///
+    /// Same as `add_array`, but the glyphs are spread over independent lanes, so that
+    /// the loop has no dependency between iterations and can be vectorized.
+    pub fn from_glyphs<T>(items: &[T], glyph: impl Fn(&T) -> u32) -> Self {
+        const LANES: usize = 8;
+
+        type head_t = hb_set_digest_bits_pattern_t<4>;
+        type mid_t = hb_set_digest_bits_pattern_t<0>;
+        type tail_t = hb_set_digest_bits_pattern_t<9>;
+
+        let mut head = [0; LANES];
+        let mut mid = [0; LANES];
+        let mut tail = [0; LANES];
+
+        let mut chunks = items.chunks_exact(LANES);
+        for chunk in &mut chunks {
+            for lane in 0..LANES {
+                let g = GlyphId(glyph(&chunk[lane]) as u16);
+                head[lane] |= head_t::mask_for(g);
+                mid[lane] |= mid_t::mask_for(g);
+                tail[lane] |= tail_t::mask_for(g);
+            }
+        }
+        for item in chunks.remainder() {
+            let g = GlyphId(glyph(item) as u16);
+            head[0] |= head_t::mask_for(g);
+            mid[0] |= mid_t::mask_for(g);
+            tail[0] |= tail_t::mask_for(g);
+        }
+
+        let fold = |lanes: [mask_t; LANES]| lanes.iter().fold(0, |acc, lane| acc | lane);
+        Self {
+            head: head_t { mask: fold(head) },
+            tail: hb_set_digest_combiner_t {
+                head: mid_t { mask: fold(mid) },
+                tail: tail_t { mask: fold(tail) },
+            },
+        }
+    }
+}
+
 #[rustfmt::skip]
 #[cfg(test)]
 mod tests {
@@ -269,4 +313,14 @@ mod tests {
         assert!(set.may_have_glyph(GlyphId(3456)));
         assert!(set.may_have_glyph(GlyphId(3460)));
     }
+
+    #[test]
+    fn test_from_glyphs() {
+        let glyphs: alloc::vec::Vec<u32> = (0..2000).map(|i| i * 37 % 65536).collect();
+        for len in [0, 1, 7, 8, 9, 100, glyphs.len()] {
+            let mut set = hb_set_digest_t::new();
+            set.add_array(glyphs[..len].iter().map(|g| GlyphId(*g as u16)));
+            assert_eq!(hb_set_digest_t::from_glyphs(&glyphs[..len], |g| *g), set);
+        }
+    }
 }
@@ -1,19 +1,25 @@
+use alloc::vec::Vec;
+use core::ops::Range;
+
+use super::buffer::{
+    hb_buffer_t, hb_glyph_info_t, GlyphPosition, HB_BUFFER_CLUSTER_LEVEL_CHARACTERS,
+};
 use super::hb_font_t;
 use super::ot_shape::{hb_ot_shape_context_t, shape_internal};
 use super::ot_shape_plan::hb_ot_shape_plan_t;
-use crate::{script, Feature, GlyphBuffer, UnicodeBuffer};
+use crate::{script, BufferClusterLevel, BufferFlags, Feature, GlyphBuffer, UnicodeBuffer};
 
 /// Shapes the buffer content using provided font and features.
 ///
 /// Consumes the buffer. You can then run [`GlyphBuffer::clear`] to get the [`UnicodeBuffer`] back
 /// without allocating a new one.
 ///
-/// If you plan to shape multiple strings using the same [`Face`] prefer [`shape_with_plan`].
-/// This is because [`ShapePlan`] initialization is pretty slow and should preferably be called
-/// once for each [`Face`].
+/// [`ShapePlan`] initialization is pretty slow, so the plan is taken from the [`Face`]'s
+/// plan cache (see [`ShapePlan::new_cached`]). If you keep your own plans around,
+/// prefer [`shape_with_plan`].
 pub fn shape(face: &hb_font_t, features: &[Feature], mut buffer: UnicodeBuffer) -> GlyphBuffer {
     buffer.0.guess_segment_properties();
-    let plan = hb_ot_shape_plan_t::new(
+    let plan = hb_ot_shape_plan_t::new_cached(
         face,
         buffer.0.direction,
         buffer.0.script,
@@ -42,7 +48,11 @@ pub fn shape_with_plan(
 ) -> GlyphBuffer {
     let mut buffer = buffer.0;
     buffer.guess_segment_properties();
+    shape_buffer(face, plan, &mut buffer);
+    GlyphBuffer(buffer)
+}
 
+pub(crate) fn shape_buffer(face: &hb_font_t, plan: &hb_ot_shape_plan_t, buffer: &mut hb_buffer_t) {
     buffer.enter();
 
     debug_assert_eq!(buffer.direction, plan.direction);
@@ -57,11 +67,11 @@ pub fn shape_with_plan(
 
         #[cfg(feature = "wasm-shaper")]
         {
-            super::shape_wasm::shape_with_wasm(face, plan, &mut buffer).unwrap_or_else(|| {
+            super::shape_wasm::shape_with_wasm(face, plan, buffer).unwrap_or_else(|| {
                 shape_internal(&mut hb_ot_shape_context_t {
                     plan,
                     face,
-                    buffer: &mut buffer,
+                    buffer,
                     target_direction,
                 });
             });
@@ -71,11 +81,443 @@ pub fn shape_with_plan(
             shape_internal(&mut hb_ot_shape_context_t {
                 plan,
                 face,
-                buffer: &mut buffer,
+                buffer,
                 target_direction,
             });
         }
     }
+}
 
-    GlyphBuffer(buffer)
+/// Shaping results of several runs, stored back to back.
+///
+/// Reuse the same value across [`Shaper::shape_batch`] calls to avoid reallocating.
+#[derive(Clone, Default, Debug)]
+pub struct GlyphRuns {
+    infos: Vec<hb_glyph_info_t>,
+    positions: Vec<GlyphPosition>,
+    runs: Vec<Range<usize>>,
+}
+
+impl GlyphRuns {
+    /// Creates a new, empty `GlyphRuns`.
+    #[inline]
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Returns the number of runs.
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.runs.len()
+    }
+
+    /// Returns `true` if there are no runs.
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.runs.is_empty()
+    }
+
+    /// Get the glyph infos of all runs.
+    #[inline]
+    pub fn glyph_infos(&self) -> &[hb_glyph_info_t] {
+        &self.infos
+    }
+
+    /// Get the glyph positions of all runs.
+    #[inline]
+    pub fn glyph_positions(&self) -> &[GlyphPosition] {
+        &self.positions
+    }
+
+    /// Get the glyph range of each run, in input order.
+    #[inline]
+    pub fn run_ranges(&self) -> &[Range<usize>] {
+        &self.runs
+    }
+
+    /// Get the glyph infos and positions of the run at `index`.
+    #[inline]
+    pub fn run(&self, index: usize) -> Option<(&[hb_glyph_info_t], &[GlyphPosition])> {
+        let range = self.runs.get(index)?.clone();
+        Some((&self.infos[range.clone()], &self.positions[range]))
+    }
+
+    /// Removes all runs, keeping the allocated memory.
+    #[inline]
+    pub fn clear(&mut self) {
+        self.infos.clear();
+        self.positions.clear();
+        self.runs.clear();
+    }
+
+    #[cfg(feature = "parallel")]
+    pub(crate) fn append(&mut self, other: &GlyphRuns) {
+        let offset = self.infos.len();
+        self.infos.extend_from_slice(&other.infos);
+        self.positions.extend_from_slice(&other.positions);
+        self.runs.extend(
+            other
+                .runs
+                .iter()
+                .map(|run| run.start + offset..run.end + offset),
+        );
+    }
+
+    fn push_run(&mut self, buffer: &hb_buffer_t) {
+        let start = self.infos.len();
+        self.infos.extend_from_slice(&buffer.info[..buffer.len]);
+        self.positions.extend_from_slice(&buffer.pos[..buffer.len]);
+        self.runs.push(start..self.infos.len());
+    }
+}
+
+/// A reusable shaper for many short runs.
+///
+/// Keeps a single buffer alive between runs, so that once its capacity has grown to fit
+/// the largest run, shaping doesn't allocate anymore.
+pub struct Shaper {
+    pub(crate) buffer: UnicodeBuffer,
+}
+
+impl Shaper {
+    /// Creates a new `Shaper`.
+    #[inline]
+    pub fn new() -> Self {
+        Shaper {
+            buffer: UnicodeBuffer::new(),
+        }
+    }
+
+    /// Set the buffer flags used for every run.
+    #[inline]
+    pub fn set_flags(&mut self, flags: BufferFlags) {
+        self.buffer.set_flags(flags);
+    }
+
+    /// Set the cluster level used for every run.
+    #[inline]
+    pub fn set_cluster_level(&mut self, cluster_level: BufferClusterLevel) {
+        self.buffer.set_cluster_level(cluster_level);
+    }
+
+    /// Shapes a sequence of `(text, range, plan)` items.
+    ///
+    /// Only `text[range]` is shaped; the rest of `text` is used as pre- and post-context.
+    /// Cluster values are byte offsets into `text`. Direction and script are taken from the
+    /// plan.
+    ///
+    /// Results are appended to `output`, one run per item, in input order.
+    ///
+    /// # Panics
+    ///
+    /// Panics if a range is out of bounds or not on a char boundary.
+    pub fn shape_batch<'a, I>(&mut self, face: &hb_font_t, items: I, output: &mut GlyphRuns)
+    where
+        I: IntoIterator<Item = (&'a str, Range<usize>, &'a hb_ot_shape_plan_t)>,
+    {
+        for (text, range, plan) in items {
+            self.shape_item(face, text, range, plan);
+            output.push_run(&self.buffer.0);
+        }
+    }
+
+    /// Reshapes `previous` after an edit of its text.
+    ///
+    /// `previous` must be the result of shaping the whole previous text as a single run
+    /// with `plan`, using byte offsets as clusters, like [`UnicodeBuffer::push_str`] does.
+    /// `text` is the whole text after the edit. The flags and the cluster level of
+    /// `previous` are used for shaping, not the ones of the shaper.
+    ///
+    /// Only a window around the edit is shaped again and spliced into `previous`.
+    /// The window is grown until both of its ends are cluster boundaries that are safe
+    /// to break in `previous` and in the reshaped window
+    /// (see [`GlyphInfo::unsafe_to_break`](crate::GlyphInfo::unsafe_to_break)), so that
+    /// the result is the same as shaping the whole `text`. This makes the cost depend
+    /// on the size of the edit rather than on the length of the text.
+    ///
+    /// With [`BufferClusterLevel::Characters`] clusters are not monotone and the whole
+    /// `text` is shaped again.
+    ///
+    /// # Panics
+    ///
+    /// Panics if `edit` doesn't match `text`, or if the clusters of `previous` are not
+    /// on char boundaries of `text`.
+    pub fn reshape(
+        &mut self,
+        face: &hb_font_t,
+        plan: &hb_ot_shape_plan_t,
+        previous: GlyphBuffer,
+        text: &str,
+        edit: &TextEdit,
+    ) -> GlyphBuffer {
+        let mut previous = previous.0;
+        let TextEdit { ref range, len } = *edit;
+        assert!(range.start <= range.end && range.start + len <= text.len());
+        let old_len = text.len() - len + range.len();
+
+        // Without glyphs, e.g. when all of the text was default ignorables that got
+        // removed, there are no boundaries to keep.
+        if previous.cluster_level == HB_BUFFER_CLUSTER_LEVEL_CHARACTERS || previous.len == 0 {
+            let end = text.len();
+            shape_item(face, &mut previous, text, 0..end, plan);
+            return GlyphBuffer(previous);
+        }
+
+        // Maps an offset of the previous text after the edit to the new text.
+        let shift = |offset: usize| offset - range.end + range.start + len;
+
+        let backward = plan.direction.is_backward();
+        let old = LogicalGlyphs {
+            infos: &previous.info[..previous.len],
+            backward,
+            text_len: old_len,
+        };
+
+        // `left..right` are the glyphs to replace, delimited by the safe boundaries
+        // closest to the edit. The window is shaped with one more safe segment on
+        // each side, so that the new glyphs can tell if those boundaries are still safe.
+        let mut left = old.safe_at_or_before(range.start);
+        let mut right = old.safe_at_or_after(range.end);
+        let mut window_start = old.safe_before(left);
+        let mut window_end = old.safe_after(right);
+
+        let saved_flags = self.buffer.0.flags;
+        let saved_cluster_level = self.buffer.0.cluster_level;
+        self.buffer.0.cluster_level = previous.cluster_level;
+
+        let mut expansions = 0;
+        let (first, last) = loop {
+            let text_start = old.position(window_start);
+            let text_end = shift(old.position(window_end));
+
+            let mut flags = previous.flags;
+            if text_start != 0 {
+                flags.remove(BufferFlags::BEGINNING_OF_TEXT);
+            }
+            if text_end != text.len() {
+                flags.remove(BufferFlags::END_OF_TEXT);
+            }
+            self.buffer.0.flags = flags;
+            shape_item(face, &mut self.buffer.0, text, text_start..text_end, plan);
+
+            let window = LogicalGlyphs {
+                infos: &self.buffer.0.info[..self.buffer.0.len],
+                backward,
+                text_len: text.len(),
+            };
+            let first = if left == window_start {
+                Some(0)
+            } else {
+                window.safe_boundary(old.position(left))
+            };
+            let last = if right == window_end {
+                Some(window.len())
+            } else {
+                window.safe_boundary(shift(old.position(right)))
+            };
+            if let (Some(first), Some(last)) = (first, last) {
+                break (first, last);
+            }
+
+            // Give up on small steps eventually and shape up to the end of the text.
+            expansions += 1;
+            if first.is_none() {
+                left = window_start;
+                window_start = if expansions < MAX_RESHAPE_EXPANSIONS {
+                    old.safe_before(left)
+                } else {
+                    0
+                };
+            }
+            if last.is_none() {
+                right = window_end;
+                window_end = if expansions < MAX_RESHAPE_EXPANSIONS {
+                    old.safe_after(right)
+                } else {
+                    old.len()
+                };
+            }
+        };
+
+        self.buffer.0.flags = saved_flags;
+        self.buffer.0.cluster_level = saved_cluster_level;
+
+        let old_count = previous.len;
+        let new_count = self.buffer.0.len;
+        let (old_range, new_range, after) = if backward {
+            (
+                old_count - right..old_count - left,
+                new_count - last..new_count - first,
+                0..old_count - right,
+            )
+        } else {
+            (left..right, first..last, right..old_count)
+        };
+
+        for info in &mut previous.info[after] {
+            info.cluster = shift(info.cluster as usize) as u32;
+        }
+        previous.info.truncate(old_count);
+        previous.pos.truncate(old_count);
+        previous.info.splice(
+            old_range.clone(),
+            self.buffer.0.info[new_range.clone()].iter().copied(),
+        );
+        previous
+            .pos
+            .splice(old_range, self.buffer.0.pos[new_range].iter().copied());
+        previous.len = previous.info.len();
+
+        GlyphBuffer(previous)
+    }
+
+    fn shape_item(
+        &mut self,
+        face: &hb_font_t,
+        text: &str,
+        range: Range<usize>,
+        plan: &hb_ot_shape_plan_t,
+    ) {
+        shape_item(face, &mut self.buffer.0, text, range, plan);
+    }
+}
+
+pub(crate) fn shape_item(
+    face: &hb_font_t,
+    buffer: &mut hb_buffer_t,
+    text: &str,
+    range: Range<usize>,
+    plan: &hb_ot_shape_plan_t,
+) {
+    // `clear` keeps the flags, but not the cluster level.
+    let cluster_level = buffer.cluster_level;
+    buffer.clear();
+    buffer.cluster_level = cluster_level;
+    buffer.direction = plan.direction;
+    buffer.script = plan.script;
+    buffer.push_str_item(text, range);
+    shape_buffer(face, plan, buffer);
+}
+
+/// Number of times [`Shaper::reshape`] grows the window by a single safe segment
+/// before shaping up to the end of the text instead.
+const MAX_RESHAPE_EXPANSIONS: usize = 4;
+
+/// A replacement of a part of a text, for [`Shaper::reshape`].
+#[derive(Clone, PartialEq, Eq, Debug)]
+pub struct TextEdit {
+    /// The replaced byte range of the previous text.
+    pub range: Range<usize>,
+    /// The byte length of the replacement.
+    pub len: usize,
+}
+
+/// The glyphs of a buffer with monotone clusters, in logical order.
+///
+/// A boundary `i` is the position before the glyph `i`, and `len()` is the end.
+struct LogicalGlyphs<'a> {
+    infos: &'a [hb_glyph_info_t],
+    backward: bool,
+    text_len: usize,
+}
+
+impl LogicalGlyphs<'_> {
+    #[inline]
+    fn len(&self) -> usize {
+        self.infos.len()
+    }
+
+    #[inline]
+    fn get(&self, index: usize) -> &hb_glyph_info_t {
+        if self.backward {
+            &self.infos[self.infos.len() - 1 - index]
+        } else {
+            &self.infos[index]
+        }
+    }
+
+    /// The text offset of a boundary.
+    fn position(&self, boundary: usize) -> usize {
+        if boundary == 0 {
+            0
+        } else if boundary == self.len() {
+            self.text_len
+        } else {
+            self.get(boundary).cluster as usize
+        }
+    }
+
+    fn is_safe(&self, boundary: usize) -> bool {
+        boundary == 0
+            || boundary == self.len()
+            || (self.get(boundary - 1).cluster != self.get(boundary).cluster
+                && !self.get(boundary).unsafe_to_break())
+    }
+
+    /// The number of glyphs with a cluster before `offset`.
+    fn count_before(&self, offset: usize) -> usize {
+        let (mut low, mut high) = (0, self.len());
+        while low < high {
+            let mid = (low + high) / 2;
+            if (self.get(mid).cluster as usize) < offset {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        low
+    }
+
+    fn safe_at_or_before(&self, offset: usize) -> usize {
+        let mut boundary = self.count_before(offset + 1);
+        while self.position(boundary) > offset || !self.is_safe(boundary) {
+            boundary -= 1;
+        }
+        boundary
+    }
+
+    fn safe_at_or_after(&self, offset: usize) -> usize {
+        let mut boundary = self.count_before(offset);
+        while boundary < self.len() && (self.position(boundary) < offset || !self.is_safe(boundary))
+        {
+            boundary += 1;
+        }
+        boundary
+    }
+
+    fn safe_before(&self, mut boundary: usize) -> usize {
+        if boundary > 0 {
+            boundary -= 1;
+            while !self.is_safe(boundary) {
+                boundary -= 1;
+            }
+        }
+        boundary
+    }
+
+    fn safe_after(&self, mut boundary: usize) -> usize {
+        if boundary < self.len() {
+            boundary += 1;
+            while !self.is_safe(boundary) {
+                boundary += 1;
+            }
+        }
+        boundary
+    }
+
+    /// The inner boundary at `offset`, if it is safe to break.
+    fn safe_boundary(&self, offset: usize) -> Option<usize> {
+        let boundary = self.count_before(offset);
+        (boundary > 0
+            && boundary < self.len()
+            && self.get(boundary).cluster as usize == offset
+            && self.is_safe(boundary))
+        .then_some(boundary)
+    }
+}
+
+impl Default for Shaper {
+    fn default() -> Self {
+        Self::new()
+    }
 }
@@ -0,0 +1,51 @@
+use core::cell::RefCell;
+use core::ops::Range;
+use rayon::prelude::*;
+
+use super::hb_font_t;
+use super::ot_shape_plan::hb_ot_shape_plan_t;
+use super::shape::{GlyphRuns, Shaper};
+
+// Runs are usually short, so don't split the work into tasks smaller than that.
+const MIN_RUNS_PER_TASK: usize = 8;
+
+std::thread_local! {
+    // One buffer per worker thread, kept alive between batches.
+    static WORKER_SHAPER: RefCell<Shaper> = RefCell::new(Shaper::new());
+}
+
+impl Shaper {
+    /// Shapes a list of independent `(text, range, plan)` items on the
+    /// [rayon](https://docs.rs/rayon) thread pool.
+    ///
+    /// Behaves like [`Shaper::shape_batch`], using this shaper's flags and cluster level,
+    /// but idle threads steal runs from busy ones. Each worker thread shapes with its own
+    /// buffer. Results are appended to `output` in input order.
+    pub fn shape_batch_parallel<'a>(
+        &self,
+        face: &hb_font_t,
+        items: &[(&'a str, Range<usize>, &'a hb_ot_shape_plan_t)],
+        output: &mut GlyphRuns,
+    ) {
+        let flags = self.buffer.flags();
+        let cluster_level = self.buffer.cluster_level();
+
+        let parts: alloc::vec::Vec<GlyphRuns> = items
+            .par_iter()
+            .with_min_len(MIN_RUNS_PER_TASK)
+            .fold(GlyphRuns::new, |mut runs, (text, range, plan)| {
+                WORKER_SHAPER.with(|shaper| {
+                    let mut shaper = shaper.borrow_mut();
+                    shaper.set_flags(flags);
+                    shaper.set_cluster_level(cluster_level);
+                    shaper.shape_batch(face, [(*text, range.clone(), *plan)], &mut runs);
+                });
+                runs
+            })
+            .collect();
+
+        for part in &parts {
+            output.append(part);
+        }
+    }
+}
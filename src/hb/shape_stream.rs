@@ -0,0 +1,207 @@
+use alloc::string::String;
+use alloc::vec::Vec;
+
+use super::buffer::{hb_buffer_t, hb_glyph_info_t, GlyphPosition, CONTEXT_LENGTH};
+use super::hb_font_t;
+use super::ot_shape_plan::hb_ot_shape_plan_t;
+use super::shape::{shape_item, Shaper};
+use crate::BufferFlags;
+
+/// Amount of pending text that is shaped at once, in bytes.
+const STREAM_CHUNK_LEN: usize = 4096;
+
+/// Glyphs of the text this close to the end of a chunk are held back,
+/// since the text that follows may still change them.
+const STREAM_LOOKAHEAD: usize = STREAM_CHUNK_LEN / 4;
+
+/// Pending text past which a chunk is cut, even if it has no safe boundary.
+const STREAM_MAX_LEN: usize = 16 * STREAM_CHUNK_LEN;
+
+impl Shaper {
+    /// Shapes a text of any length with bounded memory, passing the glyphs to `sink`
+    /// as soon as they are final.
+    ///
+    /// `text` yields consecutive pieces of the text, of any size. Pending text is shaped
+    /// with `plan` a few kilobytes at a time, using this shaper's flags and cluster level.
+    /// Direction and script are taken from the plan. Glyphs are only emitted up to a cluster
+    /// boundary that is safe to break
+    /// (see [`GlyphInfo::unsafe_to_break`](crate::GlyphInfo::unsafe_to_break)) and not too
+    /// close to the end of the pending text. The text after it is shaped again with the next
+    /// chunk, with the text before it as pre-context. This gives the same result as shaping
+    /// the whole text at once, unless no safe boundary is found in 64 KiB of text, which is
+    /// then cut at a cluster boundary anyway.
+    ///
+    /// `sink` is called with the glyph infos and positions of each chunk, in buffer order.
+    /// Chunks follow the logical order of the text, so with a backward direction each chunk
+    /// goes before the previous one. Cluster values are byte offsets into the whole text.
+    ///
+    /// # Panics
+    ///
+    /// Panics if the text is longer than `u32::MAX` bytes.
+    pub fn shape_stream<I, F>(
+        &mut self,
+        face: &hb_font_t,
+        plan: &hb_ot_shape_plan_t,
+        text: I,
+        mut sink: F,
+    ) where
+        I: IntoIterator,
+        I::Item: AsRef<str>,
+        F: FnMut(&[hb_glyph_info_t], &[GlyphPosition]),
+    {
+        let flags = self.buffer.0.flags;
+        let mut stream = Stream {
+            window: String::new(),
+            context_len: 0,
+            offset: 0,
+            limit: STREAM_CHUNK_LEN,
+            suffix_min: Vec::new(),
+        };
+
+        for piece in text {
+            let mut piece = piece.as_ref();
+            while !piece.is_empty() {
+                // Copy at most up to the limit, so that huge pieces aren't buffered whole.
+                let mut len = stream
+                    .limit
+                    .saturating_sub(stream.pending_len())
+                    .clamp(1, piece.len());
+                while !piece.is_char_boundary(len) {
+                    len += 1;
+                }
+                stream.window.push_str(&piece[..len]);
+                piece = &piece[len..];
+                assert!(stream.offset + stream.window.len() <= u32::MAX as usize);
+
+                if stream.pending_len() >= stream.limit {
+                    stream.flush(face, plan, &mut self.buffer.0, flags, false, &mut sink);
+                }
+            }
+        }
+
+        if stream.pending_len() != 0 {
+            stream.flush(face, plan, &mut self.buffer.0, flags, true, &mut sink);
+        }
+        self.buffer.0.flags = flags;
+    }
+}
+
+struct Stream {
+    // Text that hasn't been emitted yet, after `context_len` bytes of pre-context.
+    window: String,
+    context_len: usize,
+    // The offset of `window` in the whole text.
+    offset: usize,
+    // Pending length at which the next chunk is shaped.
+    limit: usize,
+    // The smallest cluster of the glyphs from each logical position on.
+    suffix_min: Vec<u32>,
+}
+
+impl Stream {
+    #[inline]
+    fn pending_len(&self) -> usize {
+        self.window.len() - self.context_len
+    }
+
+    fn flush(
+        &mut self,
+        face: &hb_font_t,
+        plan: &hb_ot_shape_plan_t,
+        buffer: &mut hb_buffer_t,
+        mut flags: BufferFlags,
+        last: bool,
+        sink: &mut impl FnMut(&[hb_glyph_info_t], &[GlyphPosition]),
+    ) {
+        if self.offset + self.context_len != 0 {
+            flags.remove(BufferFlags::BEGINNING_OF_TEXT);
+        }
+        if !last {
+            flags.remove(BufferFlags::END_OF_TEXT);
+        }
+        buffer.flags = flags;
+        let end = self.window.len();
+        shape_item(face, buffer, &self.window, self.context_len..end, plan);
+
+        let backward = plan.direction.is_backward();
+        let infos = &buffer.info[..buffer.len];
+        let (glyphs, text_end) = if last {
+            (infos.len(), end)
+        } else if let Some(cut) = self.find_cut(infos, backward, end - STREAM_LOOKAHEAD, true) {
+            cut
+        } else if self.pending_len() < STREAM_MAX_LEN {
+            // Wait for more text, but don't shape the same text over and over.
+            self.limit = (self.limit * 2).min(STREAM_MAX_LEN);
+            return;
+        } else {
+            self.find_cut(infos, backward, end, false)
+                .unwrap_or((infos.len(), end))
+        };
+        self.limit = STREAM_CHUNK_LEN;
+
+        let range = if backward {
+            buffer.len - glyphs..buffer.len
+        } else {
+            0..glyphs
+        };
+        for info in &mut buffer.info[range.clone()] {
+            info.cluster += self.offset as u32;
+        }
+        if !range.is_empty() {
+            sink(&buffer.info[range.clone()], &buffer.pos[range]);
+        }
+
+        // Keep the end of the emitted text as the pre-context of the next chunk.
+        let context_start = self.window[..text_end]
+            .char_indices()
+            .rev()
+            .take(CONTEXT_LENGTH)
+            .last()
+            .map_or(text_end, |(i, _)| i);
+        self.window.drain(..context_start);
+        self.offset += context_start;
+        self.context_len = text_end - context_start;
+    }
+
+    /// Returns the last logical boundary that splits the glyphs into clusters before
+    /// and after it, with the text after it starting at most at `max_offset`, as the
+    /// number of glyphs before it and that offset.
+    fn find_cut(
+        &mut self,
+        infos: &[hb_glyph_info_t],
+        backward: bool,
+        max_offset: usize,
+        safe_only: bool,
+    ) -> Option<(usize, usize)> {
+        let get = |i: usize| {
+            if backward {
+                &infos[infos.len() - 1 - i]
+            } else {
+                &infos[i]
+            }
+        };
+
+        // Clusters are not monotone with `BufferClusterLevel::Characters`.
+        self.suffix_min.clear();
+        self.suffix_min.resize(infos.len(), u32::MAX);
+        let mut min = u32::MAX;
+        for i in (0..infos.len()).rev() {
+            min = min.min(get(i).cluster);
+            self.suffix_min[i] = min;
+        }
+
+        let mut max = 0;
+        let mut cut = None;
+        for i in 1..infos.len() {
+            max = max.max(get(i - 1).cluster);
+            let offset = self.suffix_min[i];
+            if offset as usize > max_offset {
+                break;
+            }
+            if max < offset && !(safe_only && get(i).unsafe_to_break()) {
+                cut = Some((i, offset as usize));
+            }
+        }
+        cut
+    }
+}
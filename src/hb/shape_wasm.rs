@@ -17,65 +17,97 @@ struct ShapingData<'a> {
     buffer: &'a mut hb_buffer_t,
 }
 
+/// The compiled `Wasm` table of a face and the host functions it is linked
+/// against.
+///
+/// Both are created only once per face and cached in the face data.
+pub(crate) struct hb_wasm_shaper_t {
+    module: Module,
+    // Stores only live for a single `shape_with_wasm` call, see there.
+    linker: Linker<ShapingData<'static>>,
+}
+
+impl hb_wasm_shaper_t {
+    /// Compiles the `Wasm` table of the face, if any.
+    fn new(font: &hb_font_t) -> Option<Self> {
+        let wasm_blob = font
+            .raw_face()
+            .table(ttf_parser::Tag::from_bytes(b"Wasm"))?;
+
+        let mut config = Config::default();
+        config.compilation_mode(wasmi::CompilationMode::Lazy);
+        let engine = Engine::new(&config);
+
+        let module = Module::new(&engine, wasm_blob).ok()?;
+
+        let mut linker = Linker::new(&engine);
+
+        // Not every function defined by HarfBuzz is defined here.
+        // Only the ones used by the harfbuzz_wasm crate
+        //
+        // For more info see
+        // "Spec": https://github.com/harfbuzz/harfbuzz/blob/main/docs/wasm-shaper.md
+        // crate: https://github.com/harfbuzz/harfbuzz-wasm-examples/blob/main/harfbuzz-wasm/src/lib.rs
+        linker
+            .func_wrap("env", "face_get_upem", face_get_upem)
+            .ok()?
+            .func_wrap("env", "font_get_face", font_get_face)
+            .ok()?
+            .func_wrap("env", "font_get_glyph", font_get_glyph)
+            .ok()?
+            .func_wrap("env", "font_get_scale", font_get_scale)
+            .ok()?
+            .func_wrap("env", "font_get_glyph_extents", font_get_glyph_extents)
+            .ok()?
+            .func_wrap("env", "font_glyph_to_string", font_glyph_to_string)
+            .ok()?
+            .func_wrap("env", "font_get_glyph_h_advance", font_get_glyph_h_advance)
+            .ok()?
+            .func_wrap("env", "font_get_glyph_v_advance", font_get_glyph_v_advance)
+            .ok()?
+            .func_wrap("env", "font_copy_glyph_outline", font_copy_glyph_outline)
+            .ok()?
+            .func_wrap("env", "face_copy_table", face_copy_table)
+            .ok()?
+            .func_wrap("env", "buffer_copy_contents", buffer_copy_contents)
+            .ok()?
+            .func_wrap("env", "buffer_set_contents", buffer_set_contents)
+            .ok()?
+            .func_wrap("env", "debugprint", debugprint)
+            .ok()?
+            .func_wrap("env", "shape_with", shape_with)
+            .ok()?;
+
+        Some(hb_wasm_shaper_t { module, linker })
+    }
+}
+
 pub(crate) fn shape_with_wasm(
     font: &hb_font_t,
     plan: &hb_ot_shape_plan_t,
     buffer: &mut hb_buffer_t,
 ) -> Option<()> {
     // If font has no Wasm blob just return None to carry on as usual.
-    let wasm_blob = font
-        .raw_face()
-        .table(ttf_parser::Tag::from_bytes(b"Wasm"))?;
-
-    let mut config = Config::default();
-    config.compilation_mode(wasmi::CompilationMode::Lazy);
-    let engine = Engine::new(&config);
-
-    let module = Module::new(&engine, wasm_blob).ok()?;
-
-    let mut linker = Linker::new(&engine);
-
-    // Not every function defined by HarfBuzz is defined here.
-    // Only the ones used by the harfbuzz_wasm crate
-    //
-    // For more info see
-    // "Spec": https://github.com/harfbuzz/harfbuzz/blob/main/docs/wasm-shaper.md
-    // crate: https://github.com/harfbuzz/harfbuzz-wasm-examples/blob/main/harfbuzz-wasm/src/lib.rs
-    linker
-        .func_wrap("env", "face_get_upem", face_get_upem)
-        .ok()?
-        .func_wrap("env", "font_get_face", font_get_face)
-        .ok()?
-        .func_wrap("env", "font_get_glyph", font_get_glyph)
-        .ok()?
-        .func_wrap("env", "font_get_scale", font_get_scale)
-        .ok()?
-        .func_wrap("env", "font_get_glyph_extents", font_get_glyph_extents)
-        .ok()?
-        .func_wrap("env", "font_glyph_to_string", font_glyph_to_string)
-        .ok()?
-        .func_wrap("env", "font_get_glyph_h_advance", font_get_glyph_h_advance)
-        .ok()?
-        .func_wrap("env", "font_get_glyph_v_advance", font_get_glyph_v_advance)
-        .ok()?
-        .func_wrap("env", "font_copy_glyph_outline", font_copy_glyph_outline)
-        .ok()?
-        .func_wrap("env", "face_copy_table", face_copy_table)
-        .ok()?
-        .func_wrap("env", "buffer_copy_contents", buffer_copy_contents)
-        .ok()?
-        .func_wrap("env", "buffer_set_contents", buffer_set_contents)
-        .ok()?
-        .func_wrap("env", "debugprint", debugprint)
-        .ok()?
-        .func_wrap("env", "shape_with", shape_with)
-        .ok()?;
-
+    let shaper = font
+        .face_data
+        .wasm_shaper
+        .get_or_init(|| hb_wasm_shaper_t::new(font))
+        .as_ref()?;
+    let module = &shaper.module;
+    let engine = module.engine();
+
+    // The instance is not reused between calls, since host functions grow
+    // its memory on every call and the module may keep state around.
     let data = ShapingData { font, plan, buffer };
-    let mut store = Store::new(&engine, data);
-
-    let instance = linker
-        .instantiate(&mut store, &module)
+    // SAFETY: only the lifetimes change. The store and the instance, and so every
+    // `Caller` that can reach `data`, are dropped before this function returns,
+    // while the borrows are still alive.
+    let data = unsafe { core::mem::transmute::<ShapingData<'_>, ShapingData<'static>>(data) };
+    let mut store = Store::new(engine, data);
+
+    let instance = shaper
+        .linker
+        .instantiate(&mut store, module)
         .ok()?
         .start(&mut store)
         .ok()?;
@@ -0,0 +1,183 @@
+#[cfg(feature = "stats")]
+use alloc::vec::Vec;
+#[cfg(feature = "stats")]
+use core::time::Duration;
+
+use super::buffer::hb_buffer_t;
+#[cfg(feature = "stats")]
+use super::hb_tag_t;
+use super::ot_layout::TableIndex;
+
+/// Statistics of a shaping call.
+///
+/// Collected when enabled with [`UnicodeBuffer::set_collect_stats`](crate::UnicodeBuffer::set_collect_stats)
+/// and available from [`GlyphBuffer::stats`](crate::GlyphBuffer::stats).
+#[cfg(feature = "stats")]
+#[derive(Clone, Default, Debug)]
+pub struct ShapingStats {
+    /// Time spent normalizing the text. Also included in `substitute_pre`.
+    pub normalize: Duration,
+    /// Time spent in the substitution stage, before positioning.
+    pub substitute_pre: Duration,
+    /// Time spent positioning glyphs.
+    pub position: Duration,
+    /// Time spent in the substitution stage after positioning.
+    pub substitute_post: Duration,
+    /// Number of operations consumed, out of `max_ops`.
+    pub ops: i32,
+    /// The operations budget of the buffer.
+    ///
+    /// Lookups stop being applied once it is exhausted.
+    pub max_ops: i32,
+    /// Counters of the applied lookups, in order of first application.
+    pub lookups: Vec<LookupStats>,
+}
+
+/// Glyph counters of a single lookup, see [`ShapingStats`].
+#[cfg(feature = "stats")]
+#[derive(Clone, Copy, PartialEq, Eq, Debug)]
+pub struct LookupStats {
+    /// The table of the lookup, either `GSUB` or `GPOS`.
+    pub table: hb_tag_t,
+    /// The index of the lookup in its table.
+    pub lookup_index: u16,
+    /// Number of glyphs in the buffer, summed over the runs of the lookup.
+    ///
+    /// A lookup only runs if the digest of the buffer may have one of its glyphs.
+    pub digest_glyphs: u32,
+    /// Number of glyphs the lookup was applied to, after the mask and glyph property checks.
+    pub applied: u32,
+    /// Number of glyphs the lookup matched.
+    pub matched: u32,
+}
+
+#[derive(Clone, Copy)]
+pub(crate) enum hb_shape_stage_t {
+    Normalize,
+    SubstitutePre,
+    Position,
+    SubstitutePost,
+}
+
+/// Clears the statistics of the previous call, called when shaping starts.
+#[inline(always)]
+pub(crate) fn start(buffer: &mut hb_buffer_t) {
+    #[cfg(feature = "stats")]
+    if let Some(stats) = buffer.stats.as_mut() {
+        let mut lookups = core::mem::take(&mut stats.lookups);
+        lookups.clear();
+        **stats = ShapingStats {
+            max_ops: buffer.max_ops,
+            lookups,
+            ..ShapingStats::default()
+        };
+    }
+    #[cfg(not(feature = "stats"))]
+    let _ = buffer;
+}
+
+/// Records the consumed operations, called when shaping is done.
+#[inline(always)]
+pub(crate) fn finish(buffer: &mut hb_buffer_t) {
+    #[cfg(feature = "stats")]
+    if let Some(stats) = buffer.stats.as_mut() {
+        stats.ops = stats.max_ops - buffer.max_ops.max(0);
+    }
+    #[cfg(not(feature = "stats"))]
+    let _ = buffer;
+}
+
+/// Measures a shaping stage. Does nothing without the `stats` feature.
+pub(crate) struct hb_stage_timer_t {
+    #[cfg(feature = "stats")]
+    start: Option<std::time::Instant>,
+}
+
+impl hb_stage_timer_t {
+    #[inline(always)]
+    pub fn start(buffer: &hb_buffer_t) -> Self {
+        #[cfg(not(feature = "stats"))]
+        let _ = buffer;
+        hb_stage_timer_t {
+            #[cfg(feature = "stats")]
+            start: buffer.stats.is_some().then(std::time::Instant::now),
+        }
+    }
+
+    #[inline(always)]
+    pub fn stop(self, buffer: &mut hb_buffer_t, stage: hb_shape_stage_t) {
+        #[cfg(feature = "stats")]
+        if let (Some(start), Some(stats)) = (self.start, buffer.stats.as_mut()) {
+            *match stage {
+                hb_shape_stage_t::Normalize => &mut stats.normalize,
+                hb_shape_stage_t::SubstitutePre => &mut stats.substitute_pre,
+                hb_shape_stage_t::Position => &mut stats.position,
+                hb_shape_stage_t::SubstitutePost => &mut stats.substitute_post,
+            } += start.elapsed();
+        }
+        #[cfg(not(feature = "stats"))]
+        let _ = (buffer, stage);
+    }
+}
+
+/// Glyph counters of a lookup application. Does nothing without the `stats` feature.
+#[derive(Default)]
+pub(crate) struct hb_lookup_counters_t {
+    #[cfg(feature = "stats")]
+    applied: u32,
+    #[cfg(feature = "stats")]
+    matched: u32,
+}
+
+impl hb_lookup_counters_t {
+    #[inline(always)]
+    pub fn count(&mut self, matched: bool) {
+        #[cfg(feature = "stats")]
+        {
+            self.applied += 1;
+            self.matched += u32::from(matched);
+        }
+        #[cfg(not(feature = "stats"))]
+        let _ = matched;
+    }
+
+    #[inline(always)]
+    pub fn record(
+        self,
+        buffer: &mut hb_buffer_t,
+        table_index: TableIndex,
+        lookup_index: u16,
+        digest_glyphs: usize,
+    ) {
+        #[cfg(feature = "stats")]
+        if let Some(stats) = buffer.stats.as_mut() {
+            let table = match table_index {
+                TableIndex::GSUB => hb_tag_t::from_bytes(b"GSUB"),
+                TableIndex::GPOS => hb_tag_t::from_bytes(b"GPOS"),
+            };
+            let index = match stats
+                .lookups
+                .iter()
+                .position(|lookup| lookup.table == table && lookup.lookup_index == lookup_index)
+            {
+                Some(index) => index,
+                None => {
+                    stats.lookups.push(LookupStats {
+                        table,
+                        lookup_index,
+                        digest_glyphs: 0,
+                        applied: 0,
+                        matched: 0,
+                    });
+                    stats.lookups.len() - 1
+                }
+            };
+            let lookup = &mut stats.lookups[index];
+            lookup.digest_glyphs += digest_glyphs as u32;
+            lookup.applied += self.applied;
+            lookup.matched += self.matched;
+        }
+        #[cfg(not(feature = "stats"))]
+        let _ = (buffer, table_index, lookup_index, digest_glyphs);
+    }
+}
@@ -819,6 +819,21 @@ pub fn decompose(ab: char) -> Option<(char, char)> {
         .ok()
 }
 
+/// Returns `true` if the character has a canonical decomposition,
+/// that is if it doesn't pass the NFD quick check.
+pub fn has_decomposition(u: char) -> bool {
+    // Nothing below U+00C0 decomposes, so most text is answered by this check.
+    const FIRST: char = super::unicode_norm::DECOMPOSITION_TABLE[0].0;
+    if u < FIRST {
+        return false;
+    }
+
+    u32::from(u).wrapping_sub(S_BASE) < S_COUNT
+        || super::unicode_norm::DECOMPOSITION_TABLE
+            .binary_search_by(|item| item.0.cmp(&u))
+            .is_ok()
+}
+
 pub fn decompose_hangul(ab: char) -> Option<(char, char)> {
     let si = u32::from(ab).wrapping_sub(S_BASE);
     if si >= S_COUNT {
@@ -838,6 +853,18 @@ pub fn decompose_hangul(ab: char) -> Option<(char, char)> {
 
 #[cfg(test)]
 mod tests {
+    #[test]
+    fn has_decomposition_matches_decompose() {
+        for u in (0..0x30000).filter_map(char::from_u32) {
+            assert_eq!(
+                super::has_decomposition(u),
+                super::decompose(u).is_some(),
+                "U+{:04X}",
+                u as u32
+            );
+        }
+    }
+
     #[test]
     fn check_unicode_version() {
         assert_eq!(unicode_bidi_mirroring::UNICODE_VERSION, (15, 1, 0));
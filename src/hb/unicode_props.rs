@@ -0,0 +1,134 @@
+use alloc::boxed::Box;
+
+use super::buffer::UnicodeProps;
+use super::fonta::once_cell::OnceCell;
+use super::unicode::{CharExt, GeneralCategoryExt};
+
+// Two-level table of the `unicode_props()` of all codepoints, in blocks of
+// `BLOCK_LEN`. A block is computed on first use from the Unicode crates, which
+// takes a few lookups per codepoint, so that shaping pays a single load per
+// character afterwards. Running text only touches a handful of blocks, the first
+// one covering ASCII and Latin-1.
+const BLOCK_BITS: u32 = 8;
+const BLOCK_LEN: usize = 1 << BLOCK_BITS;
+const BLOCK_COUNT: usize = (0x10FFFF >> BLOCK_BITS) + 1;
+
+type Block = Box<[u16; BLOCK_LEN]>;
+
+#[allow(clippy::declare_interior_mutable_const)]
+const EMPTY_BLOCK: OnceCell<Block> = OnceCell::new();
+static BLOCKS: [OnceCell<Block>; BLOCK_COUNT] = [EMPTY_BLOCK; BLOCK_COUNT];
+
+/// Returns the `unicode_props()` of a character, see `hb_glyph_info_t::init_unicode_props`.
+#[inline]
+pub fn unicode_props(u: char) -> u16 {
+    let u = u as usize;
+    let block = BLOCKS[u >> BLOCK_BITS].get_or_init(|| compute_block(u >> BLOCK_BITS));
+    block[u & (BLOCK_LEN - 1)]
+}
+
+#[cold]
+fn compute_block(index: usize) -> Block {
+    let start = (index << BLOCK_BITS) as u32;
+    let mut block = Box::new([0; BLOCK_LEN]);
+    for (i, props) in block.iter_mut().enumerate() {
+        // Surrogates are not chars and are never looked up.
+        if let Some(u) = char::from_u32(start + i as u32) {
+            *props = compute(u);
+        }
+    }
+    block
+}
+
+fn compute(u: char) -> u16 {
+    let gc = u.general_category();
+    let mut props = gc.to_rb() as u16;
+
+    if u as u32 >= 0x80 {
+        if u.is_default_ignorable() {
+            props |= UnicodeProps::IGNORABLE.bits();
+
+            match u as u32 {
+                0x200C => props |= UnicodeProps::CF_ZWNJ.bits(),
+                0x200D => props |= UnicodeProps::CF_ZWJ.bits(),
+
+                // Mongolian Free Variation Selectors need to be remembered
+                // because although we need to hide them like default-ignorables,
+                // they need to non-ignorable during shaping.  This is similar to
+                // what we do for joiners in Indic-like shapers, but since the
+                // FVSes are GC=Mn, we have use a separate bit to remember them.
+                // Fixes:
+                // https://github.com/harfbuzz/harfbuzz/issues/234
+                0x180B..=0x180D | 0x180F => props |= UnicodeProps::HIDDEN.bits(),
+
+                // TAG characters need similar treatment. Fixes:
+                // https://github.com/harfbuzz/harfbuzz/issues/463
+                0xE0020..=0xE007F => props |= UnicodeProps::HIDDEN.bits(),
+
+                // COMBINING GRAPHEME JOINER should not be skipped; at least some times.
+                // https://github.com/harfbuzz/harfbuzz/issues/554
+                0x034F => props |= UnicodeProps::HIDDEN.bits(),
+
+                _ => {}
+            }
+        }
+
+        if gc.is_mark() {
+            props |= UnicodeProps::CONTINUATION.bits();
+            props |= (u.modified_combining_class() as u16) << 8;
+        }
+    }
+
+    props
+}
+
+#[cfg(test)]
+mod tests {
+    use super::super::unicode::hb_gc::*;
+    use super::*;
+
+    const IGNORABLE: u16 = UnicodeProps::IGNORABLE.bits();
+    const HIDDEN: u16 = UnicodeProps::HIDDEN.bits();
+    const CONTINUATION: u16 = UnicodeProps::CONTINUATION.bits();
+    const CF_ZWJ: u16 = UnicodeProps::CF_ZWJ.bits();
+    const CF_ZWNJ: u16 = UnicodeProps::CF_ZWNJ.bits();
+
+    fn mark(gc: u32, ccc: u8) -> u16 {
+        gc as u16 | CONTINUATION | (ccc as u16) << 8
+    }
+
+    #[test]
+    fn table_matches_unicode_data() {
+        let nsm = RB_UNICODE_GENERAL_CATEGORY_NON_SPACING_MARK;
+        let mc = RB_UNICODE_GENERAL_CATEGORY_SPACING_MARK;
+        let format = RB_UNICODE_GENERAL_CATEGORY_FORMAT as u16;
+        let expected = [
+            ('\t', RB_UNICODE_GENERAL_CATEGORY_CONTROL as u16),
+            (' ', RB_UNICODE_GENERAL_CATEGORY_SPACE_SEPARATOR as u16),
+            ('0', RB_UNICODE_GENERAL_CATEGORY_DECIMAL_NUMBER as u16),
+            ('A', RB_UNICODE_GENERAL_CATEGORY_UPPERCASE_LETTER as u16),
+            ('a', RB_UNICODE_GENERAL_CATEGORY_LOWERCASE_LETTER as u16),
+            ('\u{0085}', RB_UNICODE_GENERAL_CATEGORY_CONTROL as u16),
+            ('\u{00AD}', format | IGNORABLE),
+            ('\u{0301}', mark(nsm, 230)),
+            ('\u{0316}', mark(nsm, 220)),
+            ('\u{034F}', mark(nsm, 0) | IGNORABLE | HIDDEN),
+            ('\u{0378}', RB_UNICODE_GENERAL_CATEGORY_UNASSIGNED as u16),
+            ('\u{093E}', mark(mc, 0)),
+            // Thai SARA U is reordered before PHINTHU.
+            ('\u{0E38}', mark(nsm, 3)),
+            ('\u{180B}', mark(nsm, 0) | IGNORABLE | HIDDEN),
+            ('\u{200C}', format | IGNORABLE | CF_ZWNJ),
+            ('\u{200D}', format | IGNORABLE | CF_ZWJ),
+            ('\u{4E00}', RB_UNICODE_GENERAL_CATEGORY_OTHER_LETTER as u16),
+            ('\u{E000}', RB_UNICODE_GENERAL_CATEGORY_PRIVATE_USE as u16),
+            ('\u{FE0F}', mark(nsm, 0) | IGNORABLE),
+            ('\u{1F600}', RB_UNICODE_GENERAL_CATEGORY_OTHER_SYMBOL as u16),
+            ('\u{E0020}', format | IGNORABLE | HIDDEN),
+            ('\u{10FFFF}', RB_UNICODE_GENERAL_CATEGORY_UNASSIGNED as u16),
+        ];
+        for (u, props) in expected {
+            assert_eq!(unicode_props(u), props, "U+{:04X}", u as u32);
+        }
+    }
+}
@@ -0,0 +1,328 @@
+use alloc::boxed::Box;
+use alloc::collections::BTreeMap;
+use alloc::vec::Vec;
+use core::ops::Range;
+
+use super::buffer::glyph_flag::{UNSAFE_TO_BREAK, UNSAFE_TO_CONCAT};
+use super::buffer::{hb_buffer_t, hb_glyph_info_t, GlyphPosition};
+use super::ot_shape_plan::hb_ot_shape_plan_t;
+use super::shape::shape_buffer;
+use super::{hb_font_t, Direction};
+use crate::{BufferFlags, GlyphBuffer, UnicodeBuffer};
+
+const SPACE: u32 = 0x0020;
+
+/// Words longer than this are shaped on their own, but not cached.
+const MAX_WORD_LEN: usize = 64;
+
+// The first element of a key holds the buffer flags, the cluster level and
+// whether the word starts or ends the buffer; the codepoints follow.
+const KEY_CLUSTER_LEVEL_SHIFT: u32 = 8;
+const KEY_FIRST: u32 = 1 << 16;
+const KEY_LAST: u32 = 1 << 17;
+
+type ShapedWord = (Box<[hb_glyph_info_t]>, Box<[GlyphPosition]>);
+
+struct WordEntry {
+    stamp: u64,
+    // `None` if shaping the word on its own doesn't give the same result as in a text.
+    glyphs: Option<ShapedWord>,
+}
+
+/// A bounded cache of shaped words, for [`shape_with_word_cache`].
+///
+/// The cached results are only valid for a single face and plan, so use one cache per
+/// face and plan, or [`clear`](Self::clear) it when switching. Once the cache is full,
+/// the least recently used word is dropped.
+pub struct WordCache {
+    capacity: usize,
+    stamp: u64,
+    hits: u64,
+    entries: BTreeMap<Box<[u32]>, WordEntry>,
+    order: BTreeMap<u64, Box<[u32]>>,
+    key: Vec<u32>,
+    words: Vec<Range<usize>>,
+    infos: Vec<hb_glyph_info_t>,
+    positions: Vec<GlyphPosition>,
+    scratch: hb_buffer_t,
+}
+
+impl WordCache {
+    /// Creates a new cache, holding up to `capacity` words.
+    pub fn new(capacity: usize) -> Self {
+        WordCache {
+            capacity,
+            stamp: 0,
+            hits: 0,
+            entries: BTreeMap::new(),
+            order: BTreeMap::new(),
+            key: Vec::new(),
+            words: Vec::new(),
+            infos: Vec::new(),
+            positions: Vec::new(),
+            scratch: hb_buffer_t::new(),
+        }
+    }
+
+    /// Returns the maximum number of cached words.
+    #[inline]
+    pub fn capacity(&self) -> usize {
+        self.capacity
+    }
+
+    /// Returns the number of cached words.
+    #[inline]
+    pub fn len(&self) -> usize {
+        self.entries.len()
+    }
+
+    /// Returns `true` if no words are cached.
+    #[inline]
+    pub fn is_empty(&self) -> bool {
+        self.entries.is_empty()
+    }
+
+    /// Returns how many words were served from the cache so far.
+    ///
+    /// Words that have to be shaped as a part of the text are not counted.
+    #[inline]
+    pub fn hits(&self) -> u64 {
+        self.hits
+    }
+
+    /// Removes all cached words.
+    pub fn clear(&mut self) {
+        self.entries.clear();
+        self.order.clear();
+    }
+
+    // Shapes `buffer` word by word. Returns `false`, leaving `buffer` as is,
+    // if it has to be shaped as a whole.
+    fn shape_words(
+        &mut self,
+        face: &hb_font_t,
+        plan: &hb_ot_shape_plan_t,
+        buffer: &mut hb_buffer_t,
+    ) -> bool {
+        let len = buffer.len;
+        if self.capacity == 0
+            || len == 0
+            || buffer.direction != Direction::LeftToRight
+            || buffer.context_len != [0, 0]
+            || plan
+                .user_features
+                .iter()
+                .any(|feature| !feature.is_global())
+            || buffer.info[..len]
+                .windows(2)
+                .any(|pair| pair[0].cluster > pair[1].cluster)
+        {
+            return false;
+        }
+
+        self.words.clear();
+        let mut start = 0;
+        for (i, info) in buffer.info[..len].iter().enumerate() {
+            if info.glyph_id == SPACE {
+                self.words.push(start..i + 1);
+                start = i + 1;
+            }
+        }
+        if start < len {
+            self.words.push(start..len);
+        }
+
+        let edge_flags = BufferFlags::BEGINNING_OF_TEXT | BufferFlags::END_OF_TEXT;
+        let meta =
+            (buffer.flags - edge_flags).bits() | buffer.cluster_level << KEY_CLUSTER_LEVEL_SHIFT;
+        let produce_unsafe_to_concat = buffer.flags.contains(BufferFlags::PRODUCE_UNSAFE_TO_CONCAT);
+
+        let words = core::mem::take(&mut self.words);
+        let mut key = core::mem::take(&mut self.key);
+        self.infos.clear();
+        self.positions.clear();
+        let mut complete = true;
+        for (index, word) in words.iter().enumerate() {
+            let first = index == 0;
+            let last = index + 1 == words.len();
+
+            let infos = &buffer.info[word.clone()];
+            key.clear();
+            key.push(
+                meta | if first {
+                    KEY_FIRST | (buffer.flags & BufferFlags::BEGINNING_OF_TEXT).bits()
+                } else {
+                    0
+                } | if last {
+                    KEY_LAST | (buffer.flags & BufferFlags::END_OF_TEXT).bits()
+                } else {
+                    0
+                },
+            );
+            key.extend(infos.iter().map(|info| info.glyph_id));
+
+            let shaped;
+            let glyphs = if word.len() > MAX_WORD_LEN {
+                shaped = self.shape_word(face, plan, buffer, word.clone(), first, last);
+                shaped.as_ref()
+            } else {
+                let hit = self.touch(&key);
+                if !hit {
+                    let glyphs = self.shape_word(face, plan, buffer, word.clone(), first, last);
+                    self.insert(&key, glyphs);
+                }
+                let glyphs = self.entries[&key[..]].glyphs.as_ref();
+                if hit && glyphs.is_some() {
+                    self.hits += 1;
+                }
+                glyphs
+            };
+
+            let Some((glyph_infos, glyph_positions)) = glyphs else {
+                complete = false;
+                break;
+            };
+
+            // Cached clusters are indices into the word.
+            self.infos.extend(glyph_infos.iter().map(|glyph| {
+                let mut glyph = *glyph;
+                glyph.cluster = infos[glyph.cluster as usize].cluster;
+                if !produce_unsafe_to_concat && glyph.mask & UNSAFE_TO_BREAK == 0 {
+                    glyph.mask &= !UNSAFE_TO_CONCAT;
+                }
+                glyph
+            }));
+            self.positions.extend_from_slice(glyph_positions);
+        }
+        self.words = words;
+        self.key = key;
+
+        if complete {
+            core::mem::swap(&mut buffer.info, &mut self.infos);
+            core::mem::swap(&mut buffer.pos, &mut self.positions);
+            buffer.len = buffer.info.len();
+            buffer.have_positions = true;
+        }
+        complete
+    }
+
+    // Returns `None` if the word isn't safe to concat at one of its inner ends.
+    fn shape_word(
+        &mut self,
+        face: &hb_font_t,
+        plan: &hb_ot_shape_plan_t,
+        buffer: &hb_buffer_t,
+        word: Range<usize>,
+        first: bool,
+        last: bool,
+    ) -> Option<ShapedWord> {
+        let scratch = &mut self.scratch;
+        scratch.clear();
+        scratch.flags = buffer.flags | BufferFlags::PRODUCE_UNSAFE_TO_CONCAT;
+        if !first {
+            scratch.flags.remove(BufferFlags::BEGINNING_OF_TEXT);
+        }
+        if !last {
+            scratch.flags.remove(BufferFlags::END_OF_TEXT);
+        }
+        scratch.cluster_level = buffer.cluster_level;
+        scratch.invisible = buffer.invisible;
+        scratch.direction = buffer.direction;
+        scratch.script = buffer.script;
+        scratch.language = buffer.language.clone();
+
+        scratch.ensure(word.len());
+        for (i, info) in buffer.info[word].iter().enumerate() {
+            scratch.add(info.glyph_id, i as u32);
+        }
+        shape_buffer(face, plan, scratch);
+
+        let glyphs = &scratch.info[..scratch.len];
+        let unsafe_to_concat = |info: &hb_glyph_info_t| info.mask & UNSAFE_TO_CONCAT != 0;
+        match (glyphs.first(), glyphs.last()) {
+            (Some(head), Some(tail))
+                if (first || !unsafe_to_concat(head)) && (last || !unsafe_to_concat(tail)) =>
+            {
+                Some((glyphs.into(), scratch.pos[..scratch.len].into()))
+            }
+            _ => None,
+        }
+    }
+
+    // Marks a word as recently used. Returns `false` if it isn't cached.
+    fn touch(&mut self, key: &[u32]) -> bool {
+        let Some(entry) = self.entries.get_mut(key) else {
+            return false;
+        };
+        self.stamp += 1;
+        if let Some(key) = self.order.remove(&entry.stamp) {
+            self.order.insert(self.stamp, key);
+        }
+        entry.stamp = self.stamp;
+        true
+    }
+
+    fn insert(&mut self, key: &[u32], glyphs: Option<ShapedWord>) {
+        if self.entries.len() >= self.capacity {
+            if let Some((_, oldest)) = self.order.pop_first() {
+                self.entries.remove(&oldest);
+            }
+        }
+        self.stamp += 1;
+        let key: Box<[u32]> = key.into();
+        self.order.insert(self.stamp, key.clone());
+        self.entries.insert(
+            key,
+            WordEntry {
+                stamp: self.stamp,
+                glyphs,
+            },
+        );
+    }
+}
+
+impl core::fmt::Debug for WordCache {
+    fn fmt(&self, f: &mut core::fmt::Formatter<'_>) -> core::fmt::Result {
+        f.debug_struct("WordCache")
+            .field("capacity", &self.capacity)
+            .field("len", &self.entries.len())
+            .finish()
+    }
+}
+
+/// Shapes the buffer content using the provided font and plan, reusing the results of
+/// previously shaped words.
+///
+/// The text is split after each space and every word, with its trailing space, is shaped
+/// on its own. Those results are stored in `cache` and reused for the next occurrences of
+/// the word. A word is only shaped on its own if that gives the same result as shaping it
+/// as a part of the text, that is when it's safe to concat at both of its ends
+/// (see [`BufferFlags::PRODUCE_UNSAFE_TO_CONCAT`]). Otherwise the whole buffer is shaped,
+/// just like [`shape_with_plan`](crate::shape_with_plan) does. This is also the case for
+/// text that is not left-to-right, buffers with pre- or post-context or non-monotone
+/// clusters, and plans with features that only apply to a range.
+///
+/// It is up to the caller to ensure that the shape plan matches the properties of the provided
+/// buffer, and that `cache` is only used with a single face and plan.
+pub fn shape_with_word_cache(
+    face: &hb_font_t,
+    plan: &hb_ot_shape_plan_t,
+    buffer: UnicodeBuffer,
+    cache: &mut WordCache,
+) -> GlyphBuffer {
+    let mut buffer = buffer.0;
+    buffer.guess_segment_properties();
+    if !cache.shape_words(face, plan, &mut buffer) {
+        shape_buffer(face, plan, &mut buffer);
+    }
+    GlyphBuffer(buffer)
+}
+
+#[cfg(test)]
+mod tests {
+    #[test]
+    fn test_word_cache_is_send_and_sync() {
+        fn ensure_send_and_sync<T: Send + Sync>() {}
+        ensure_send_and_sync::<super::WordCache>();
+    }
+}
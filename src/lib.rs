@@ -18,8 +18,17 @@ pub use hb::buffer::hb_glyph_info_t as GlyphInfo;
 pub use hb::buffer::{GlyphBuffer, GlyphPosition, UnicodeBuffer};
 pub use hb::common::{script, Direction, Feature, Language, Script, Variation};
 pub use hb::face::hb_font_t as Face;
+pub use hb::face::{CharSet, OwnedFace};
 pub use hb::ot_shape_plan::hb_ot_shape_plan_t as ShapePlan;
-pub use hb::shape::{shape, shape_with_plan};
+pub use hb::shape::{shape, shape_with_plan, GlyphRuns, Shaper, TextEdit};
+pub use hb::word_cache::{shape_with_word_cache, WordCache};
+
+#[cfg(feature = "stats")]
+pub use hb::stats::{LookupStats, ShapingStats};
+
+#[cfg(feature = "bench")]
+#[doc(hidden)]
+pub use hb::ot_shape::bench;
 
 bitflags::bitflags! {
     /// Flags for buffers.
@@ -0,0 +1,94 @@
+use harfruzz::{Direction, Face, GlyphRuns, ShapePlan, Shaper, UnicodeBuffer};
+
+#[test]
+fn batch_matches_single_runs() {
+    let font_data = std::fs::read("tests/fonts/rb_custom/PT_Sans-Caption-Web-Regular.ttf").unwrap();
+    let face = Face::from_slice(&font_data, 0).unwrap();
+    let plan = ShapePlan::new(
+        &face,
+        Direction::LeftToRight,
+        Some(harfruzz::script::LATIN),
+        None,
+        &[],
+    );
+
+    let text = "Hello, world! fi ffi";
+    let ranges = [0..5, 5..7, 7..13, 13..text.len()];
+
+    let mut shaper = Shaper::new();
+    let mut runs = GlyphRuns::new();
+    // Shape twice to make sure that nothing leaks between batches.
+    for _ in 0..2 {
+        runs.clear();
+        shaper.shape_batch(
+            &face,
+            ranges.iter().map(|range| (text, range.clone(), &plan)),
+            &mut runs,
+        );
+
+        assert_eq!(runs.len(), ranges.len());
+        for (index, range) in ranges.iter().enumerate() {
+            let mut buffer = UnicodeBuffer::new();
+            buffer.set_pre_context(&text[..range.start]);
+            for (i, c) in text[range.clone()].char_indices() {
+                buffer.add(c, (range.start + i) as u32);
+            }
+            buffer.set_post_context(&text[range.end..]);
+            buffer.set_direction(Direction::LeftToRight);
+            buffer.set_script(harfruzz::script::LATIN);
+            let expected = harfruzz::shape_with_plan(&face, &plan, buffer);
+
+            let (infos, positions) = runs.run(index).unwrap();
+            assert_eq!(infos.len(), expected.len());
+            for (a, b) in infos.iter().zip(expected.glyph_infos()) {
+                assert_eq!((a.glyph_id, a.cluster), (b.glyph_id, b.cluster));
+            }
+            for (a, b) in positions.iter().zip(expected.glyph_positions()) {
+                assert_eq!(
+                    (a.x_advance, a.y_advance, a.x_offset, a.y_offset),
+                    (b.x_advance, b.y_advance, b.x_offset, b.y_offset)
+                );
+            }
+        }
+    }
+}
+
+#[cfg(feature = "parallel")]
+#[test]
+fn parallel_batch_keeps_input_order() {
+    let font_data = std::fs::read("tests/fonts/rb_custom/PT_Sans-Caption-Web-Regular.ttf").unwrap();
+    let face = Face::from_slice(&font_data, 0).unwrap();
+    let plan = ShapePlan::new(
+        &face,
+        Direction::LeftToRight,
+        Some(harfruzz::script::LATIN),
+        None,
+        &[],
+    );
+
+    let text = "The quick brown fox jumps over the lazy dog. ".repeat(50);
+    let items: Vec<_> = text
+        .split_inclusive(' ')
+        .scan(0, |offset, word| {
+            let range = *offset..*offset + word.len();
+            *offset = range.end;
+            Some((text.as_str(), range, &plan))
+        })
+        .collect();
+
+    let mut shaper = Shaper::new();
+    let mut expected = GlyphRuns::new();
+    shaper.shape_batch(&face, items.iter().cloned(), &mut expected);
+
+    let mut runs = GlyphRuns::new();
+    shaper.shape_batch_parallel(&face, &items, &mut runs);
+
+    assert_eq!(runs.run_ranges(), expected.run_ranges());
+    let ids = |runs: &GlyphRuns| -> Vec<_> {
+        runs.glyph_infos()
+            .iter()
+            .map(|info| (info.glyph_id, info.cluster))
+            .collect()
+    };
+    assert_eq!(ids(&runs), ids(&expected));
+}
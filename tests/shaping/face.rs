@@ -0,0 +1,147 @@
+use std::str::FromStr;
+
+use harfruzz::{Face, OwnedFace, SerializeFlags, UnicodeBuffer, Variation};
+
+fn advances(face: &Face, text: &str) -> Vec<i32> {
+    let mut buffer = UnicodeBuffer::new();
+    buffer.push_str(text);
+    let glyph_buffer = harfruzz::shape(face, &[], buffer);
+    glyph_buffer
+        .glyph_positions()
+        .iter()
+        .map(|pos| pos.x_advance)
+        .collect()
+}
+
+#[test]
+fn set_variations_resets_advances() {
+    let font_data =
+        std::fs::read("tests/fonts/text-rendering-tests/AdobeVFPrototype-Subset.otf").unwrap();
+    let variations = [Variation::from_str("wght=900").unwrap()];
+
+    let mut face = Face::from_slice(&font_data, 0).unwrap();
+    let default_advances = advances(&face, "$$");
+    face.set_variations(&variations);
+    let varied_advances = advances(&face, "$$");
+    assert_ne!(varied_advances, default_advances);
+
+    let mut fresh_face = Face::from_slice(&font_data, 0).unwrap();
+    fresh_face.set_variations(&variations);
+    assert_eq!(varied_advances, advances(&fresh_face, "$$"));
+
+    let default_face = Face::from_slice(&font_data, 0).unwrap();
+    assert_eq!(default_advances, advances(&default_face, "$$"));
+}
+
+#[test]
+fn pair_pos_cache_keeps_positions() {
+    let font_data = std::fs::read("tests/fonts/rb_custom/PT_Sans-Caption-Web-Regular.ttf").unwrap();
+    // Long enough for the kerning subtables to get their pair matrices.
+    let text = "AVATAR Type, Tw. LT. yo Wa. ".repeat(20);
+
+    let face = Face::from_slice(&font_data, 0).unwrap();
+    let mut cached_face = face.clone();
+    cached_face.set_pair_pos_cache(true);
+    for _ in 0..2 {
+        assert_eq!(advances(&cached_face, &text), advances(&face, &text));
+    }
+}
+
+fn extents(face: &Face, text: &str) -> String {
+    let mut buffer = UnicodeBuffer::new();
+    buffer.push_str(text);
+    harfruzz::shape(face, &[], buffer).serialize(face, SerializeFlags::GLYPH_EXTENTS)
+}
+
+#[test]
+fn cached_extents_match_fresh_face() {
+    let font_data = std::fs::read("tests/fonts/rb_custom/PT_Sans-Caption-Web-Regular.ttf").unwrap();
+
+    let face = Face::from_slice(&font_data, 0).unwrap();
+    let expected = extents(&face, "Wave ÿ!");
+    assert!(expected.contains('<'));
+    assert_eq!(extents(&face, "Wave ÿ!"), expected);
+
+    let mut sized_face = face.clone();
+    sized_face.set_pixels_per_em(Some((16, 16)));
+    assert_eq!(extents(&sized_face, "Wave ÿ!"), expected);
+}
+
+#[test]
+fn set_variations_resets_extents() {
+    let font_data = std::fs::read("tests/fonts/in-house/HBTest-VF.ttf").unwrap();
+    let variations = [Variation::from_str("TEST=509").unwrap()];
+
+    let mut face = Face::from_slice(&font_data, 0).unwrap();
+    let default_extents = extents(&face, "AA");
+    assert!(default_extents.contains('<'));
+    face.set_variations(&variations);
+    let varied_extents = extents(&face, "AA");
+    assert_ne!(varied_extents, default_extents);
+
+    let mut fresh_face = Face::from_slice(&font_data, 0).unwrap();
+    fresh_face.set_variations(&variations);
+    assert_eq!(varied_extents, extents(&fresh_face, "AA"));
+}
+
+#[test]
+fn owned_face_matches_borrowed_face() {
+    let font_data =
+        std::fs::read("tests/fonts/text-rendering-tests/AdobeVFPrototype-Subset.otf").unwrap();
+    let variations = [Variation::from_str("wght=900").unwrap()];
+
+    let mut face = Face::from_slice(&font_data, 0).unwrap();
+    face.set_variations(&variations);
+
+    let owned_face = {
+        let mut owned_face = OwnedFace::from_data(font_data.clone(), 0).unwrap();
+        owned_face.set_variations(&variations);
+        owned_face.clone()
+    };
+    assert_eq!(owned_face.data(), &font_data[..]);
+    assert_eq!(advances(owned_face.face(), "$$"), advances(&face, "$$"));
+}
+
+#[test]
+fn char_set_matches_cmap() {
+    let font_data = std::fs::read("tests/fonts/rb_custom/PT_Sans-Caption-Web-Regular.ttf").unwrap();
+    let face = Face::from_slice(&font_data, 0).unwrap();
+    let set = face.char_set();
+    assert!(!set.is_empty());
+
+    // ASCII doesn't decompose, so the shaped glyph is the cmap one.
+    for c in (0x20u8..0x7F).map(char::from) {
+        let mut buffer = UnicodeBuffer::new();
+        buffer.push_str(c.encode_utf8(&mut [0; 4]));
+        let glyph_buffer = harfruzz::shape(&face, &[], buffer);
+        assert_eq!(set.contains(c), glyph_buffer.glyph_infos()[0].glyph_id != 0);
+    }
+
+    assert!(set.contains('A') && !set.contains('\u{4E00}'));
+    assert_eq!(set.first_uncovered("AVATAR of the office"), None);
+    assert_eq!(set.first_uncovered("AVATAR of the \u{4E00}"), Some(14));
+    // Clones share the set.
+    assert!(core::ptr::eq(face.clone().char_set(), set));
+}
+
+#[test]
+fn char_set_matches_cmap_formats() {
+    for path in [
+        "tests/fonts/rb_custom/PT_Sans-Caption-Web-Regular.ttf",
+        "tests/fonts/aots/cmap0_font1.otf",
+        "tests/fonts/aots/cmap6_font1.otf",
+        "tests/fonts/aots/cmap10_font1.otf",
+        "tests/fonts/aots/cmap12_font1.otf",
+        "tests/fonts/text-rendering-tests/Zycon.ttf",
+    ] {
+        let font_data = std::fs::read(path).unwrap();
+        let face = Face::from_slice(&font_data, 0).unwrap();
+        let set = face.char_set();
+        assert!(!set.is_empty(), "{}", path);
+        // Characters mapped to glyph 0 are not covered.
+        for c in (0..=0x10FFFF).filter_map(char::from_u32) {
+            let mapped = face.glyph_index(c).map_or(false, |gid| gid.0 != 0);
+            assert_eq!(set.contains(c), mapped, "{} U+{:04X}", path, c as u32);
+        }
+    }
+}
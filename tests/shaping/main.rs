@@ -1,10 +1,18 @@
 mod aots;
+mod batch;
 mod custom;
+mod face;
 mod in_house;
 mod macos;
+mod plan;
+mod reshape;
+#[cfg(feature = "stats")]
+mod stats;
+mod stream;
 mod text_rendering_tests;
 #[cfg(feature = "wasm-shaper")]
 mod wasm;
+mod word_cache;
 
 use std::str::FromStr;
 
@@ -0,0 +1,78 @@
+use harfruzz::ttf_parser::Tag;
+use harfruzz::{Direction, Face, Feature, Script, SerializeFlags, ShapePlan, UnicodeBuffer};
+
+fn shape(
+    face: &Face,
+    plan: &ShapePlan,
+    direction: Direction,
+    script: Script,
+    text: &str,
+) -> String {
+    let mut buffer = UnicodeBuffer::new();
+    buffer.push_str(text);
+    buffer.set_direction(direction);
+    buffer.set_script(script);
+    harfruzz::shape_with_plan(face, plan, buffer).serialize(face, SerializeFlags::default())
+}
+
+fn check_round_trip(font_path: &str, direction: Direction, script: Script, text: &str) {
+    let font_data = std::fs::read(font_path).unwrap();
+    let face = Face::from_slice(&font_data, 0).unwrap();
+    let features = [Feature::new(Tag::from_bytes(b"liga"), 0, 2..5)];
+    let plan = ShapePlan::new(&face, direction, Some(script), None, &features);
+
+    let bytes = plan.to_bytes(&face).unwrap();
+    let loaded = ShapePlan::from_bytes(&face, &bytes).unwrap();
+    assert_eq!(loaded.to_bytes(&face).unwrap(), bytes);
+    assert_eq!(
+        shape(&face, &loaded, direction, script, text),
+        shape(&face, &plan, direction, script, text)
+    );
+
+    // Truncated or trailing data is rejected.
+    for len in 0..bytes.len() {
+        assert!(ShapePlan::from_bytes(&face, &bytes[..len]).is_none());
+    }
+    let mut longer = bytes.clone();
+    longer.push(0);
+    assert!(ShapePlan::from_bytes(&face, &longer).is_none());
+}
+
+#[test]
+fn plan_round_trip() {
+    check_round_trip(
+        "tests/fonts/rb_custom/PT_Sans-Caption-Web-Regular.ttf",
+        Direction::LeftToRight,
+        harfruzz::script::LATIN,
+        "AVATAR office, fi ffl",
+    );
+}
+
+#[test]
+fn plan_round_trip_with_shaper_data() {
+    check_round_trip(
+        "tests/fonts/in-house/NotoNastaliqUrdu-Regular.ttf",
+        Direction::RightToLeft,
+        harfruzz::script::ARABIC,
+        "سلام دنیا",
+    );
+}
+
+#[test]
+fn plan_from_other_face() {
+    let latin_data =
+        std::fs::read("tests/fonts/rb_custom/PT_Sans-Caption-Web-Regular.ttf").unwrap();
+    let latin_face = Face::from_slice(&latin_data, 0).unwrap();
+    let urdu_data = std::fs::read("tests/fonts/in-house/NotoNastaliqUrdu-Regular.ttf").unwrap();
+    let urdu_face = Face::from_slice(&urdu_data, 0).unwrap();
+
+    let plan = ShapePlan::new(
+        &latin_face,
+        Direction::LeftToRight,
+        Some(harfruzz::script::LATIN),
+        None,
+        &[],
+    );
+    let bytes = plan.to_bytes(&latin_face).unwrap();
+    assert!(ShapePlan::from_bytes(&urdu_face, &bytes).is_none());
+}
@@ -0,0 +1,119 @@
+use harfruzz::{
+    BufferFlags, Direction, Face, GlyphBuffer, Script, ShapePlan, Shaper, TextEdit, UnicodeBuffer,
+};
+
+fn plan(face: &Face, direction: Direction, script: Script) -> ShapePlan {
+    ShapePlan::new(face, direction, Some(script), None, &[])
+}
+
+fn shape(
+    face: &Face,
+    plan: &ShapePlan,
+    direction: Direction,
+    script: Script,
+    flags: BufferFlags,
+    text: &str,
+) -> GlyphBuffer {
+    let mut buffer = UnicodeBuffer::new();
+    buffer.push_str(text);
+    buffer.set_direction(direction);
+    buffer.set_script(script);
+    buffer.set_flags(flags | BufferFlags::PRODUCE_UNSAFE_TO_CONCAT);
+    harfruzz::shape_with_plan(face, plan, buffer)
+}
+
+fn glyphs(buffer: &GlyphBuffer) -> Vec<(u32, u32, i32, i32, i32, bool, bool)> {
+    buffer
+        .glyph_infos()
+        .iter()
+        .zip(buffer.glyph_positions())
+        .map(|(info, pos)| {
+            (
+                info.glyph_id,
+                info.cluster,
+                pos.x_advance,
+                pos.x_offset,
+                pos.y_offset,
+                info.unsafe_to_break(),
+                info.unsafe_to_concat(),
+            )
+        })
+        .collect()
+}
+
+// Applies each `(range, replacement)` edit in turn, comparing with a full reshape each time.
+fn check_edits(
+    face: &Face,
+    direction: Direction,
+    script: Script,
+    flags: BufferFlags,
+    text: &str,
+    edits: &[(core::ops::Range<usize>, &str)],
+) {
+    let plan = plan(face, direction, script);
+    let mut shaper = Shaper::new();
+    let mut text = text.to_string();
+    let mut buffer = shape(face, &plan, direction, script, flags, &text);
+    for (range, replacement) in edits {
+        text.replace_range(range.clone(), replacement);
+        let edit = TextEdit {
+            range: range.clone(),
+            len: replacement.len(),
+        };
+        buffer = shaper.reshape(face, &plan, buffer, &text, &edit);
+        let expected = shape(face, &plan, direction, script, flags, &text);
+        assert_eq!(glyphs(&buffer), glyphs(&expected), "{}", text);
+    }
+}
+
+#[test]
+fn reshape_matches_full_shaping() {
+    let font_data = std::fs::read("tests/fonts/rb_custom/PT_Sans-Caption-Web-Regular.ttf").unwrap();
+    let face = Face::from_slice(&font_data, 0).unwrap();
+    check_edits(
+        &face,
+        Direction::LeftToRight,
+        harfruzz::script::LATIN,
+        BufferFlags::empty(),
+        "AVATAR of the office, WAVE fi",
+        &[
+            (0..0, "T"),
+            (2..3, ""),
+            (10..10, "f"),
+            (14..20, "ffi ffl"),
+            (28..28, " V"),
+            (0..5, ""),
+            (0..24, "AV"),
+        ],
+    );
+}
+
+#[test]
+fn reshape_right_to_left() {
+    let font_data = std::fs::read("tests/fonts/in-house/NotoNastaliqUrdu-Regular.ttf").unwrap();
+    let face = Face::from_slice(&font_data, 0).unwrap();
+    // Insertions and deletions change the joining forms of the neighbouring letters.
+    check_edits(
+        &face,
+        Direction::RightToLeft,
+        harfruzz::script::ARABIC,
+        BufferFlags::empty(),
+        "سلام دنیا",
+        &[(2..2, "ب"), (0..0, "ک "), (5..7, ""), (18..20, "م")],
+    );
+}
+
+#[test]
+fn reshape_removed_default_ignorables() {
+    let font_data = std::fs::read("tests/fonts/rb_custom/PT_Sans-Caption-Web-Regular.ttf").unwrap();
+    let face = Face::from_slice(&font_data, 0).unwrap();
+    // The previous text shapes to no glyphs at all.
+    check_edits(
+        &face,
+        Direction::LeftToRight,
+        harfruzz::script::LATIN,
+        BufferFlags::REMOVE_DEFAULT_IGNORABLES,
+        "\u{200B}",
+        &[(3..3, "AV"), (0..5, "\u{200B}\u{200D}"), (0..0, "W")],
+    );
+}
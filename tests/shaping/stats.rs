@@ -0,0 +1,51 @@
+use harfruzz::{Face, UnicodeBuffer};
+
+#[test]
+fn stats_count_lookups_and_ops() {
+    let font_data = std::fs::read("tests/fonts/rb_custom/PT_Sans-Caption-Web-Regular.ttf").unwrap();
+    let face = Face::from_slice(&font_data, 0).unwrap();
+
+    let mut buffer = UnicodeBuffer::new();
+    buffer.push_str("office AVATAR");
+    let glyphs = harfruzz::shape(&face, &[], buffer);
+    assert!(glyphs.stats().is_none());
+
+    let mut buffer = glyphs.clear();
+    buffer.push_str("office AVATAR");
+    buffer.set_collect_stats(true);
+    let glyphs = harfruzz::shape(&face, &[], buffer);
+    let stats = glyphs.stats().unwrap();
+
+    assert!(stats.ops > 0 && stats.ops <= stats.max_ops);
+    assert!(!stats.lookups.is_empty());
+    for lookup in &stats.lookups {
+        assert!(lookup.digest_glyphs > 0);
+        assert!(lookup.matched <= lookup.applied);
+        assert!(lookup.applied <= lookup.digest_glyphs);
+    }
+    // The `ffi` ligature and the kerning of `AVATAR`.
+    let matched = |table: &[u8; 4]| {
+        stats
+            .lookups
+            .iter()
+            .filter(|lookup| lookup.table == harfruzz::ttf_parser::Tag::from_bytes(table))
+            .map(|lookup| lookup.matched)
+            .sum::<u32>()
+    };
+    assert!(matched(b"GSUB") > 0);
+    assert!(matched(b"GPOS") > 0);
+}
+
+#[test]
+fn stats_skip_lookups_by_digest() {
+    let font_data = std::fs::read("tests/fonts/rb_custom/PT_Sans-Caption-Web-Regular.ttf").unwrap();
+    let face = Face::from_slice(&font_data, 0).unwrap();
+
+    // The font has no CJK glyphs and no lookup covers `.notdef`.
+    let mut buffer = UnicodeBuffer::new();
+    buffer.push_str("中文");
+    buffer.set_collect_stats(true);
+    let glyphs = harfruzz::shape(&face, &[], buffer);
+    assert!(glyphs.glyph_infos().iter().all(|info| info.glyph_id == 0));
+    assert!(glyphs.stats().unwrap().lookups.is_empty());
+}
@@ -0,0 +1,93 @@
+use harfruzz::{Direction, Face, GlyphBuffer, Script, ShapePlan, Shaper, UnicodeBuffer};
+
+type Glyph = (u32, u32, i32, i32, i32);
+
+fn glyphs<'a>(
+    infos: &'a [harfruzz::GlyphInfo],
+    positions: &'a [harfruzz::GlyphPosition],
+) -> impl Iterator<Item = Glyph> + 'a {
+    infos.iter().zip(positions).map(|(info, pos)| {
+        (
+            info.glyph_id,
+            info.cluster,
+            pos.x_advance,
+            pos.x_offset,
+            pos.y_offset,
+        )
+    })
+}
+
+fn shape(
+    face: &Face,
+    plan: &ShapePlan,
+    direction: Direction,
+    script: Script,
+    text: &str,
+) -> GlyphBuffer {
+    let mut buffer = UnicodeBuffer::new();
+    buffer.push_str(text);
+    buffer.set_direction(direction);
+    buffer.set_script(script);
+    harfruzz::shape_with_plan(face, plan, buffer)
+}
+
+// Streams `text` in pieces of `piece_len` bytes and compares with shaping it at once.
+fn check_stream(face: &Face, direction: Direction, script: Script, text: &str, piece_len: usize) {
+    let plan = ShapePlan::new(face, direction, Some(script), None, &[]);
+    let expected = shape(face, &plan, direction, script, text);
+
+    let mut pieces = Vec::new();
+    let mut rest = text;
+    while !rest.is_empty() {
+        let mut len = piece_len.min(rest.len());
+        while !rest.is_char_boundary(len) {
+            len += 1;
+        }
+        pieces.push(&rest[..len]);
+        rest = &rest[len..];
+    }
+
+    let mut chunks = Vec::new();
+    Shaper::new().shape_stream(face, &plan, pieces, |infos, positions| {
+        chunks.push(glyphs(infos, positions).collect::<Vec<_>>());
+    });
+    assert!(chunks.len() > 1);
+    if direction == Direction::RightToLeft {
+        chunks.reverse();
+    }
+
+    assert_eq!(
+        chunks.concat(),
+        glyphs(expected.glyph_infos(), expected.glyph_positions()).collect::<Vec<_>>()
+    );
+}
+
+#[test]
+fn stream_matches_full_shaping() {
+    let font_data = std::fs::read("tests/fonts/rb_custom/PT_Sans-Caption-Web-Regular.ttf").unwrap();
+    let face = Face::from_slice(&font_data, 0).unwrap();
+    let text = "AVATAR of the office, WAVE fi ffl Tw. ".repeat(400);
+    for piece_len in [7, 1000, text.len()] {
+        check_stream(
+            &face,
+            Direction::LeftToRight,
+            harfruzz::script::LATIN,
+            &text,
+            piece_len,
+        );
+    }
+}
+
+#[test]
+fn stream_right_to_left() {
+    let font_data = std::fs::read("tests/fonts/in-house/NotoNastaliqUrdu-Regular.ttf").unwrap();
+    let face = Face::from_slice(&font_data, 0).unwrap();
+    let text = "سلام دنیا ".repeat(600);
+    check_stream(
+        &face,
+        Direction::RightToLeft,
+        harfruzz::script::ARABIC,
+        &text,
+        100,
+    );
+}
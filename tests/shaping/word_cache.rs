@@ -0,0 +1,101 @@
+use harfruzz::{Direction, Face, GlyphBuffer, ShapePlan, UnicodeBuffer, WordCache};
+
+fn buffer(text: &str) -> UnicodeBuffer {
+    let mut buffer = UnicodeBuffer::new();
+    buffer.push_str(text);
+    buffer.set_direction(Direction::LeftToRight);
+    buffer.set_script(harfruzz::script::LATIN);
+    buffer
+}
+
+fn glyphs(buffer: &GlyphBuffer) -> Vec<(u32, u32, i32, i32, i32)> {
+    buffer
+        .glyph_infos()
+        .iter()
+        .zip(buffer.glyph_positions())
+        .map(|(info, pos)| {
+            (
+                info.glyph_id,
+                info.cluster,
+                pos.x_advance,
+                pos.x_offset,
+                pos.y_offset,
+            )
+        })
+        .collect()
+}
+
+#[test]
+fn word_cache_matches_full_shaping() {
+    let font_data = std::fs::read("tests/fonts/rb_custom/PT_Sans-Caption-Web-Regular.ttf").unwrap();
+    let face = Face::from_slice(&font_data, 0).unwrap();
+    let plan = ShapePlan::new(
+        &face,
+        Direction::LeftToRight,
+        Some(harfruzz::script::LATIN),
+        None,
+        &[],
+    );
+
+    let texts = [
+        "The office AVATAR, WAVE fi ffl",
+        "AVATAR The  office",
+        "Привет, мир! Γειά σου κόσμε",
+        "office",
+        " T. V. ",
+    ];
+
+    let mut cache = WordCache::new(64);
+    // The second round is served from the cache.
+    for _ in 0..2 {
+        for text in texts {
+            let expected = harfruzz::shape_with_plan(&face, &plan, buffer(text));
+            let cached = harfruzz::shape_with_word_cache(&face, &plan, buffer(text), &mut cache);
+            assert_eq!(glyphs(&cached), glyphs(&expected), "{}", text);
+        }
+    }
+}
+
+#[test]
+fn word_cache_reuses_repeated_words() {
+    // No layout tables, so every word can be shaped on its own.
+    let font_data = std::fs::read("tests/fonts/rb_custom/LaBelleAurore.ttf").unwrap();
+    let face = Face::from_slice(&font_data, 0).unwrap();
+    let plan = ShapePlan::new(
+        &face,
+        Direction::LeftToRight,
+        Some(harfruzz::script::LATIN),
+        None,
+        &[],
+    );
+
+    let mut cache = WordCache::new(64);
+    // The first and the last word are keyed apart from the inner ones,
+    // so only the second inner "two " is a hit.
+    let text = "one two one two one";
+    let expected = harfruzz::shape_with_plan(&face, &plan, buffer(text));
+    let cached = harfruzz::shape_with_word_cache(&face, &plan, buffer(text), &mut cache);
+    assert_eq!(glyphs(&cached), glyphs(&expected));
+    assert_eq!(cache.hits(), 1);
+    assert_eq!(cache.len(), 4);
+}
+
+#[test]
+fn word_cache_is_bounded() {
+    let font_data = std::fs::read("tests/fonts/rb_custom/PT_Sans-Caption-Web-Regular.ttf").unwrap();
+    let face = Face::from_slice(&font_data, 0).unwrap();
+    let plan = ShapePlan::new(
+        &face,
+        Direction::LeftToRight,
+        Some(harfruzz::script::LATIN),
+        None,
+        &[],
+    );
+
+    let mut cache = WordCache::new(3);
+    let text = "one two three four five six";
+    let expected = harfruzz::shape_with_plan(&face, &plan, buffer(text));
+    let cached = harfruzz::shape_with_word_cache(&face, &plan, buffer(text), &mut cache);
+    assert_eq!(glyphs(&cached), glyphs(&expected));
+    assert_eq!(cache.len(), 3);
+}